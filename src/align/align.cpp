@@ -126,7 +126,7 @@ void align_worker(size_t thread_id, Search::Config* cfg)
 		DpStat dp_stat;
 		const bool parallel = config.swipe_all && (cfg->target->seqs().size() >= cfg->query->seqs().size());
 		while (hits.get()) {
-			if (config.frame_shift != 0) {
+			if (config.frame_shift != 0 && config.query_range_culling) {
 				TextBuffer* buf = legacy_pipeline(hits, *cfg, stat);
 				OutputSink::get().push(hits.query, buf);
 				hits.release();
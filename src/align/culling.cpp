@@ -19,48 +19,52 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #include <algorithm>
+#include <iterator>
 #include "target.h"
 #include "../basic/config.h"
 #include "../data/reference.h"
 
 using std::vector;
-using std::list;
 
 namespace Extension {
 
-static void max_hsp_culling(list<Hsp>& hsps) {
-	if (config.max_hsps > 0 && hsps.size() > config.max_hsps) {
-		list<Hsp>::iterator i = hsps.begin();
-		for (unsigned n = 0; n < config.max_hsps; ++n)
-			++i;
-		hsps.erase(i, hsps.end());
-	}
+static void max_hsp_culling(vector<Hsp>& hsps) {
+	if (config.max_hsps > 0 && hsps.size() > config.max_hsps)
+		hsps.erase(hsps.begin() + config.max_hsps, hsps.end());
 }
 
-static void inner_culling(list<Hsp>& hsps, int source_query_len) {
-	for (Hsp& h : hsps)
-		h.query_source_range = TranslatedPosition::absolute_interval(TranslatedPosition(h.query_range.begin_, Frame(h.frame)), TranslatedPosition(h.query_range.end_, Frame(h.frame)), source_query_len);
-	hsps.sort();
+static void inner_culling(vector<Hsp>& hsps, int source_query_len) {
+	if (!config.frame_shift)
+		for (Hsp& h : hsps)
+			h.query_source_range = TranslatedPosition::absolute_interval(TranslatedPosition(h.query_range.begin_, Frame(h.frame)), TranslatedPosition(h.query_range.end_, Frame(h.frame)), source_query_len);
+	std::stable_sort(hsps.begin(), hsps.end());
 	const double overlap = config.inner_culling_overlap / 100.0;
-	for (list<Hsp>::iterator i = hsps.begin(); i != hsps.end();) {
-		if (i->is_enveloped_by(hsps.begin(), i, overlap))
-			i = hsps.erase(i);
-		else
-			++i;
+	vector<Hsp>::iterator out = hsps.begin();
+	for (vector<Hsp>::iterator i = hsps.begin(); i != hsps.end(); ++i) {
+		if (i->is_enveloped_by(hsps.begin(), out, overlap))
+			continue;
+		if (out != i)
+			*out = std::move(*i);
+		++out;
 	}
+	hsps.erase(out, hsps.end());
 	if (config.max_hsps > 0)
 		max_hsp_culling(hsps);
 }
 
 void Target::inner_culling(int source_query_len) {
-	list<Hsp> hsps;
+	vector<Hsp> hsps;
+	size_t n = 0;
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame)
-		hsps.splice(hsps.end(), hsp[frame]);
-	Extension::inner_culling(hsps, source_query_len);
-	while (!hsps.empty()) {
-		auto& l = hsp[hsps.front().frame];
-		l.splice(l.end(), hsps, hsps.begin());
+		n += hsp[frame].size();
+	hsps.reserve(n);
+	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
+		hsps.insert(hsps.end(), std::make_move_iterator(hsp[frame].begin()), std::make_move_iterator(hsp[frame].end()));
+		hsp[frame].clear();
 	}
+	Extension::inner_culling(hsps, source_query_len);
+	for (Hsp& h : hsps)
+		hsp[h.frame].push_back(std::move(h));
 }
 
 void Match::inner_culling(int source_query_len)
@@ -128,15 +132,17 @@ void Target::apply_filters(int source_query_len, const char *query_title, const
 	filter_score = 0;
 	filter_evalue = DBL_MAX;
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
-		for (list<Hsp>::iterator i = hsp[frame].begin(); i != hsp[frame].end();) {
+		vector<Hsp>::iterator out = hsp[frame].begin();
+		for (vector<Hsp>::iterator i = hsp[frame].begin(); i != hsp[frame].end(); ++i) {
 			if (filter_hsp(*i, source_query_len, query_title, len, title, query_seq, seq))
-				i = hsp[frame].erase(i);
-			else {
-				filter_score = std::max(filter_score, i->score);
-				filter_evalue = std::min(filter_evalue, i->evalue);
-				++i;
-			}
+				continue;
+			filter_score = std::max(filter_score, i->score);
+			filter_evalue = std::min(filter_evalue, i->evalue);
+			if (out != i)
+				*out = std::move(*i);
+			++out;
 		}
+		hsp[frame].erase(out, hsp[frame].end());
 	}
 }
 
@@ -145,12 +151,9 @@ void Match::apply_filters(int source_query_len, const char *query_title, const S
 	const char *title = targets.ids()[target_block_id];
 	const Sequence seq = targets.seqs()[target_block_id];
 	const int len = seq.length();
-	for (list<Hsp>::iterator i = hsp.begin(); i != hsp.end();) {
-		if (filter_hsp(*i, source_query_len, query_title, len, title, query_seq, seq))
-			i = hsp.erase(i);
-		else
-			++i;
-	}
+	hsp.erase(std::remove_if(hsp.begin(), hsp.end(), [&](const Hsp& h) {
+		return filter_hsp(h, source_query_len, query_title, len, title, query_seq, seq);
+	}), hsp.end());
 	filter_evalue = hsp.empty() ? DBL_MAX : hsp.front().evalue;
 	filter_score = hsp.empty() ? 0 : hsp.front().score;
 }
@@ -82,6 +82,7 @@ vector<Target> extend(size_t query_id,
 	const Sequence *query_seq,
 	int source_query_len,
 	const Bias_correction *query_cb,
+	QueryProfiles& profiles,
 	const Stats::Composition& query_comp,
 	FlatArray<SeedHit> &seed_hits,
 	vector<uint32_t> &target_block_ids,
@@ -96,20 +97,22 @@ vector<Target> extend(size_t query_id,
 	if (cfg.lazy_masking && !config.global_ranking_targets)
 		stat.inc(Statistics::MASKED_LAZY, lazy_masking(target_block_ids, *cfg.target));
 
-	if (cfg.gapped_filter_evalue > 0.0 && config.global_ranking_targets == 0 && (!align_mode.query_translated || query_seq[0].length() >= GAPPED_FILTER_MIN_QLEN)) {
+	if (cfg.gapped_filter_evalue > 0.0 && config.global_ranking_targets == 0 && config.frame_shift == 0 && (!align_mode.query_translated || query_seq[0].length() >= GAPPED_FILTER_MIN_QLEN)) {
 		timer.go("Computing gapped filter");
-		gapped_filter(query_seq, query_cb, seed_hits, target_block_ids, stat, flags, cfg);
+		gapped_filter(query_seq, query_cb, profiles, seed_hits, target_block_ids, stat, flags, cfg);
 		if ((flags & DP::PARALLEL) == 0)
 			stat.inc(Statistics::TIME_GAPPED_FILTER, timer.microseconds());
 	}
 	stat.inc(Statistics::TARGET_HITS3, target_block_ids.size());
 
 	timer.go("Computing chaining");
-	vector<WorkTarget> targets = ungapped_stage(query_seq, query_cb, query_comp, seed_hits, target_block_ids, flags, stat, *cfg.target);
+	vector<WorkTarget> targets = ungapped_stage(query_seq, query_cb, profiles, query_comp, seed_hits, target_block_ids, flags, stat, *cfg.target);
 	if ((flags & DP::PARALLEL) == 0)
 		stat.inc(Statistics::TIME_CHAINING, timer.microseconds());
 
-	return align(targets, query_seq, query_cb, source_query_len, flags, stat);
+	if (config.frame_shift)
+		return align_frameshift(targets, cfg.query->translated(query_id), source_query_len, flags);
+	return align(targets, query_seq, query_cb, profiles, source_query_len, flags, stat);
 }
 
 vector<Match> extend(
@@ -141,6 +144,7 @@ vector<Match> extend(
 			query_cb.emplace_back(query_seq[i]);
 		timer.finish();
 	}
+	QueryProfiles profiles(query_seq.data(), query_cb.data(), contexts);
 	Stats::Composition query_comp;
 	if (Stats::CBS::matrix_adjust(config.comp_based_stats))
 		query_comp = Stats::composition(query_seq[0]);
@@ -191,7 +195,7 @@ vector<Match> extend(
 
 		//multiplier = std::max(multiplier, chunk_size_multiplier(seed_hits_chunk, (int)query_seq.front().length()));
 
-		vector<Target> v = extend(query_id, query_seq.data(), source_query_len, query_cb.data(), query_comp, multi_chunk ? seed_hits_chunk : seed_hits, multi_chunk ? target_block_ids_chunk : target_block_ids, cfg, stat, flags);
+		vector<Target> v = extend(query_id, query_seq.data(), source_query_len, query_cb.data(), profiles, query_comp, multi_chunk ? seed_hits_chunk : seed_hits, multi_chunk ? target_block_ids_chunk : target_block_ids, cfg, stat, flags);
 		const size_t n = v.size();
 		stat.inc(Statistics::TARGET_HITS4, v.size());
 		bool new_hits = false;
@@ -215,7 +219,7 @@ vector<Match> extend(
 	}
 
 	if (config.swipe_all)
-		aligned_targets = full_db_align(query_seq.data(), query_cb.data(), flags, stat, *cfg.target);
+		aligned_targets = full_db_align(query_seq.data(), query_cb.data(), profiles, flags, stat, *cfg.target);
 
 	/*if (multiplier > 1)
 		stat.inc(Statistics::HARD_QUERIES);*/
@@ -227,7 +231,8 @@ vector<Match> extend(
 	stat.inc(Statistics::TARGET_HITS5, aligned_targets.size());
 	timer.finish();
 
-	vector<Match> matches = align(aligned_targets, query_seq.data(), query_cb.data(), source_query_len, flags, stat);
+	vector<Match> matches = config.frame_shift ? align_frameshift(aligned_targets, cfg.query->translated(query_id), source_query_len, flags)
+		: align(aligned_targets, query_seq.data(), query_cb.data(), profiles, source_query_len, flags, stat);
 	std::sort(matches.begin(), matches.end(), config.toppercent == 100.0 ? Match::cmp_evalue : Match::cmp_score);
 	return matches;
 }
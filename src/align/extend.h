@@ -19,7 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #pragma once
-#include <list>
+#include <vector>
+#include <array>
 #include <algorithm>
 #include <float.h>
 #include "../basic/match.h"
@@ -36,8 +37,8 @@ struct Match {
 		filter_evalue(filter_evalue),
 		ungapped_score(ungapped_score)
 	{}
-	void add_hit(std::list<Hsp> &list, std::list<Hsp>::iterator it) {
-		hsp.splice(hsp.end(), list, it);
+	void add_hit(Hsp&& h) {
+		hsp.push_back(std::move(h));
 	}
 	static bool cmp_evalue(const Match& m, const Match& n) {
 		return m.filter_evalue < n.filter_evalue || (m.filter_evalue == n.filter_evalue && cmp_score(m, n));
@@ -45,7 +46,7 @@ struct Match {
 	static bool cmp_score(const Match& m, const Match& n) {
 		return m.filter_score > n.filter_score || (m.filter_score == n.filter_score && m.target_block_id < n.target_block_id);
 	}
-	Match(size_t target_block_id, std::array<std::list<Hsp>, MAX_CONTEXT> &hsp, int ungapped_score);
+	Match(size_t target_block_id, std::array<std::vector<Hsp>, MAX_CONTEXT> &hsp, int ungapped_score);
 	void inner_culling(int source_query_len);
 	void max_hsp_culling();
 	void apply_filters(int source_query_len, const char *query_title, const Sequence& query_seq, const Block& targets);
@@ -53,7 +54,7 @@ struct Match {
 	int filter_score;
 	double filter_evalue;
 	int ungapped_score;
-	std::list<Hsp> hsp;
+	std::vector<Hsp> hsp;
 };
 
 std::vector<Match> extend(size_t query_id, Search::Hit* begin, Search::Hit* end, const Search::Config &cfg, Statistics &stat, int flags);
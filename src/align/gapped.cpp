@@ -19,7 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #include <map>
+#include <list>
 #include <algorithm>
+#include <iterator>
 #include "target.h"
 #include "../dp/dp.h"
 #include "../util/interval.h"
@@ -28,8 +30,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 using std::vector;
 using std::array;
-using std::list;
 using std::map;
+using std::list;
 using std::endl;
 
 namespace Extension {
@@ -67,15 +69,21 @@ int band(int len) {
 	}
 }
 
-Match::Match(size_t target_block_id, std::array<std::list<Hsp>, MAX_CONTEXT> &hsps, int ungapped_score):
+Match::Match(size_t target_block_id, std::array<std::vector<Hsp>, MAX_CONTEXT> &hsps, int ungapped_score):
 	target_block_id(target_block_id),
 	filter_score(0),
 	filter_evalue(DBL_MAX),
 	ungapped_score(ungapped_score)
 {
+	size_t n = 0;
 	for (unsigned i = 0; i < align_mode.query_contexts; ++i)
-		hsp.splice(hsp.end(), hsps[i]);
-	hsp.sort();
+		n += hsps[i].size();
+	hsp.reserve(n);
+	for (unsigned i = 0; i < align_mode.query_contexts; ++i) {
+		hsp.insert(hsp.end(), std::make_move_iterator(hsps[i].begin()), std::make_move_iterator(hsps[i].end()));
+		hsps[i].clear();
+	}
+	std::stable_sort(hsp.begin(), hsp.end());
 	if (!hsp.empty()) {
 		filter_evalue = hsp.front().evalue;
 		filter_score = hsp.front().score;
@@ -140,7 +148,7 @@ void add_dp_targets(const WorkTarget& target, int target_idx, const Sequence* qu
 	}
 }
 
-vector<Target> align(const vector<WorkTarget> &targets, const Sequence *query_seq, const Bias_correction *query_cb, int source_query_len, int flags, Statistics &stat) {
+vector<Target> align(const vector<WorkTarget> &targets, const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int source_query_len, int flags, Statistics &stat) {
 	array<array<vector<DpTarget>, 3>, MAX_CONTEXT> dp_targets;
 	vector<Target> r;
 	if (targets.empty())
@@ -161,7 +169,7 @@ vector<Target> align(const vector<WorkTarget> &targets, const Sequence *query_se
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
 		if (dp_targets[frame].empty())
 			continue;
-		list<Hsp> hsp = DP::BandedSwipe::swipe(
+		vector<Hsp> hsp = DP::BandedSwipe::swipe(
 			query_seq[frame],
 			dp_targets[frame][0],
 			dp_targets[frame][1],
@@ -169,10 +177,11 @@ vector<Target> align(const vector<WorkTarget> &targets, const Sequence *query_se
 			nullptr,
 			Frame(frame),
 			Stats::CBS::hauser(config.comp_based_stats) ? &query_cb[frame] : nullptr,
+			&profiles,
 			flags,
 			stat);
-		while (!hsp.empty())
-			r[hsp.front().swipe_target].add_hit(hsp, hsp.begin());
+		for (Hsp& h : hsp)
+			r[h.swipe_target].add_hit(std::move(h));
 	}
 
 	vector<Target> r2;
@@ -187,16 +196,78 @@ vector<Target> align(const vector<WorkTarget> &targets, const Sequence *query_se
 	return r2;
 }
 
-vector<Target> full_db_align(const Sequence *query_seq, const Bias_correction *query_cb, int flags, Statistics &stat, const Block& target_block) {	
+static const int FRAMESHIFT_BAND = 32;
+
+static void add_frameshift_targets(const WorkTarget& target, int target_idx, int qlen, array<vector<DpTarget>, 2>& dp_targets) {
+	const int band = config.padding > 0 ? config.padding : FRAMESHIFT_BAND,
+		slen = (int)target.seq.length();
+	vector<interval> ranges;
+	for (int strand = FORWARD; strand <= REVERSE; ++strand) {
+		ranges.clear();
+		for (unsigned frame = strand * 3; frame < unsigned(strand * 3 + 3); ++frame)
+			for (const Hsp_traits& hsp : target.hsp[frame])
+				ranges.emplace_back(std::max(hsp.d_min - band, -(slen - 1)), std::min(hsp.d_max + 1 + band, qlen));
+		if (ranges.empty())
+			continue;
+		std::sort(ranges.begin(), ranges.end(), [](const interval& a, const interval& b) { return a.begin_ < b.begin_; });
+		interval r = ranges.front();
+		for (vector<interval>::const_iterator i = ranges.begin() + 1; i < ranges.end(); ++i)
+			if (i->begin_ <= r.end_)
+				r.end_ = std::max(r.end_, i->end_);
+			else {
+				dp_targets[strand].emplace_back(target.seq, r.begin_, r.end_, 0, 0, target_idx);
+				r = *i;
+			}
+		dp_targets[strand].emplace_back(target.seq, r.begin_, r.end_, 0, 0, target_idx);
+	}
+}
+
+template<typename _t>
+static void frameshift_swipe(const TranslatedSequence& query, array<vector<DpTarget>, 2>& dp_targets, bool score_only, int flags, vector<_t>& out) {
+	DpStat dp_stat;
+	for (int strand = FORWARD; strand <= REVERSE; ++strand) {
+		list<Hsp> hsp = banded_3frame_swipe(query, Strand(strand), dp_targets[strand].begin(), dp_targets[strand].end(), dp_stat, score_only, flags & DP::PARALLEL);
+		for (Hsp& h : hsp)
+			out[h.swipe_target].add_hit(std::move(h));
+	}
+}
+
+vector<Target> align_frameshift(const vector<WorkTarget>& targets, const TranslatedSequence& query, int source_query_len, int flags) {
+	array<vector<DpTarget>, 2> dp_targets;
+	vector<Target> r;
+	if (targets.empty())
+		return r;
+	r.reserve(targets.size());
+	const int qlen = (int)query.index(0).length();
+	for (int i = 0; i < (int)targets.size(); ++i) {
+		add_frameshift_targets(targets[i], i, qlen, dp_targets);
+		r.emplace_back(targets[i].block_id, targets[i].seq, targets[i].ungapped_score.front(), targets[i].matrix);
+	}
+
+	frameshift_swipe(query, dp_targets, (flags & DP::TRACEBACK) == 0, flags, r);
+
+	vector<Target> r2;
+	r2.reserve(r.size());
+	for (vector<Target>::iterator i = r.begin(); i != r.end(); ++i)
+		if (i->filter_evalue != DBL_MAX) {
+			if (flags & DP::TRACEBACK)
+				i->inner_culling(source_query_len);
+			r2.push_back(std::move(*i));
+		}
+
+	return r2;
+}
+
+vector<Target> full_db_align(const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int flags, Statistics &stat, const Block& target_block) {	
 	vector<DpTarget> v;
 	vector<Target> r;
 	Stats::TargetMatrix matrix;
-	list<Hsp> hsp;
+	vector<Hsp> hsp;
 	const SequenceSet& ref_seqs = target_block.seqs();
 	
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
 		ContainerIterator<DpTarget, SequenceSet> target_it(ref_seqs, ref_seqs.size());
-		list<Hsp> frame_hsp = DP::BandedSwipe::swipe(
+		vector<Hsp> frame_hsp = DP::BandedSwipe::swipe(
 			query_seq[frame],
 			v,
 			v,
@@ -204,19 +275,20 @@ vector<Target> full_db_align(const Sequence *query_seq, const Bias_correction *q
 			&target_it,
 			Frame(frame),
 			Stats::CBS::hauser(config.comp_based_stats) ? &query_cb[frame] : nullptr,
+			&profiles,
 			flags | DP::FULL_MATRIX,
 			stat);
-		hsp.splice(hsp.begin(), frame_hsp, frame_hsp.begin(), frame_hsp.end());
+		hsp.insert(hsp.begin(), std::make_move_iterator(frame_hsp.begin()), std::make_move_iterator(frame_hsp.end()));
 	}
 
 	map<unsigned, unsigned> subject_idx;
-	while (!hsp.empty()) {
-		size_t block_id = hsp.begin()->swipe_target;
+	for (Hsp& h : hsp) {
+		size_t block_id = h.swipe_target;
 		const auto it = subject_idx.emplace(block_id, (unsigned)r.size());
 		if (it.second)
 			r.emplace_back(block_id, ref_seqs[block_id], 0, matrix);
 		unsigned i = it.first->second;
-		r[i].add_hit(hsp, hsp.begin());
+		r[i].add_hit(std::move(h));
 	}
 
 	return r;
@@ -240,7 +312,7 @@ void add_dp_targets(const Target &target, int target_idx, const Sequence *query_
 	}
 }
 
-vector<Match> align(vector<Target> &targets, const Sequence *query_seq, const Bias_correction *query_cb, int source_query_len, int flags, Statistics &stat) {
+vector<Match> align(vector<Target> &targets, const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int source_query_len, int flags, Statistics &stat) {
 	array<array<vector<DpTarget>, 3>, MAX_CONTEXT> dp_targets;
 	vector<Match> r;
 	if (targets.empty())
@@ -273,7 +345,7 @@ vector<Match> align(vector<Target> &targets, const Sequence *query_seq, const Bi
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
 		if (dp_targets[frame].empty())
 			continue;
-		list<Hsp> hsp = DP::BandedSwipe::swipe(
+		vector<Hsp> hsp = DP::BandedSwipe::swipe(
 			query_seq[frame],
 			dp_targets[frame][0],
 			dp_targets[frame][1],
@@ -281,10 +353,11 @@ vector<Match> align(vector<Target> &targets, const Sequence *query_seq, const Bi
 			nullptr,
 			Frame(frame),
 			Stats::CBS::hauser(config.comp_based_stats) ? &query_cb[frame] : nullptr,
+			&profiles,
 			flags,
 			stat);
-		while (!hsp.empty())
-			r[hsp.front().swipe_target].add_hit(hsp, hsp.begin());
+		for (Hsp& h : hsp)
+			r[h.swipe_target].add_hit(std::move(h));
 	}
 
 	for (Match &match : r)
@@ -293,4 +366,32 @@ vector<Match> align(vector<Target> &targets, const Sequence *query_seq, const Bi
 	return r;
 }
 
+vector<Match> align_frameshift(vector<Target>& targets, const TranslatedSequence& query, int source_query_len, int flags) {
+	array<vector<DpTarget>, 2> dp_targets;
+	vector<Match> r;
+	if (targets.empty())
+		return r;
+	r.reserve(targets.size());
+
+	if ((output_format->hsp_values == Output::NONE && config.max_hsps == 1) || (flags & DP::TRACEBACK)) {
+		for (Target &t : targets)
+			r.emplace_back(t.block_id, t.hsp, t.ungapped_score);
+		return r;
+	}
+
+	for (int i = 0; i < (int)targets.size(); ++i) {
+		for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame)
+			for (const Hsp& hsp : targets[i].hsp[frame])
+				dp_targets[frame < 3 ? FORWARD : REVERSE].emplace_back(targets[i].seq, hsp.d_begin, hsp.d_end, 0, 0, i);
+		r.emplace_back(targets[i].block_id, targets[i].ungapped_score);
+	}
+
+	frameshift_swipe(query, dp_targets, false, flags, r);
+
+	for (Match &match : r)
+		match.inner_culling(source_query_len);
+
+	return r;
+}
+
 }
@@ -72,28 +72,22 @@ void gapped_filter_worker(size_t i, size_t thread_id, const LongScoreProfile *qu
 	}
 }
 
-void gapped_filter(const Sequence* query, const Bias_correction* query_cbs, FlatArray<SeedHit>& seed_hits, std::vector<uint32_t>& target_block_ids, Statistics& stat, int flags, const Search::Config &params) {
+void gapped_filter(const Sequence* query, const Bias_correction* query_cbs, QueryProfiles& profiles, FlatArray<SeedHit>& seed_hits, std::vector<uint32_t>& target_block_ids, Statistics& stat, int flags, const Search::Config &params) {
 	if (seed_hits.size() == 0)
 		return;
-	vector<LongScoreProfile> query_profile;
-	query_profile.reserve(align_mode.query_contexts);
-	for (unsigned i = 0; i < align_mode.query_contexts; ++i)
-		if(Stats::CBS::hauser(config.comp_based_stats))
-			query_profile.emplace_back(query[i], query_cbs[i]);
-		else
-			query_profile.emplace_back(query[i]);
-	
+	const LongScoreProfile* query_profile = profiles.long_profiles();
+
 	FlatArray<SeedHit> hits_out;
 	vector<uint32_t> target_ids_out;
 	
 	if(flags & DP::PARALLEL) {
 		mutex mtx;
-		Util::Parallel::scheduled_thread_pool_auto(config.threads_, seed_hits.size(), gapped_filter_worker, query_profile.data(), &seed_hits, target_block_ids.data(), &hits_out, &target_ids_out, &mtx, &params);
+		Util::Parallel::scheduled_thread_pool_auto(config.threads_, seed_hits.size(), gapped_filter_worker, query_profile, &seed_hits, target_block_ids.data(), &hits_out, &target_ids_out, &mtx, &params);
 	}
 	else {
 
 		for (size_t i = 0; i < seed_hits.size(); ++i) {
-			if (gapped_filter(seed_hits.begin(i), seed_hits.end(i), query_profile.data(), target_block_ids[i], stat, params)) {
+			if (gapped_filter(seed_hits.begin(i), seed_hits.end(i), query_profile, target_block_ids[i], stat, params)) {
 				target_ids_out.push_back(target_block_ids[i]);
 				hits_out.push_back(seed_hits.begin(i), seed_hits.end(i));
 			}
@@ -23,7 +23,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <set>
 #include <vector>
 #include <stdint.h>
-#include <list>
 #include <mutex>
 #include <float.h>
 #include "../basic/diagonal_segment.h"
@@ -33,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "extend.h"
 #include "../util/data_structures/flat_array.h"
 #include "../stats/cbs.h"
+#include "../dp/score_profile.h"
 
 struct SequenceSet;
 
@@ -68,11 +68,12 @@ struct WorkTarget {
 	size_t block_id;
 	Sequence seq;
 	std::array<int, MAX_CONTEXT> ungapped_score;
-	std::array<std::list<Hsp_traits>, MAX_CONTEXT> hsp;
+	std::array<std::vector<Hsp_traits>, MAX_CONTEXT> hsp;
 	Stats::TargetMatrix matrix;
 };
 
-std::vector<WorkTarget> ungapped_stage(const Sequence* query_seq, const Bias_correction* query_cb, const Stats::Composition& query_comp, FlatArray<SeedHit>& seed_hits, const std::vector<uint32_t>& target_block_ids, int flags, Statistics& stat, const Block& target_block);
+int band(int len);
+std::vector<WorkTarget> ungapped_stage(const Sequence* query_seq, const Bias_correction* query_cb, QueryProfiles& profiles, const Stats::Composition& query_comp, FlatArray<SeedHit>& seed_hits, const std::vector<uint32_t>& target_block_ids, int flags, Statistics& stat, const Block& target_block);
 
 struct Target {
 
@@ -85,11 +86,11 @@ struct Target {
 		matrix(matrix)
 	{}
 
-	void add_hit(std::list<Hsp> &list, std::list<Hsp>::iterator it) {
-		std::list<Hsp> &l = hsp[it->frame];
-		l.splice(l.end(), list, it);
-		filter_evalue = std::min(filter_evalue, l.back().evalue);
-		filter_score = std::max(filter_score, l.back().score);
+	void add_hit(Hsp&& h) {
+		std::vector<Hsp> &v = hsp[h.frame];
+		v.push_back(std::move(h));
+		filter_evalue = std::min(filter_evalue, v.back().evalue);
+		filter_score = std::max(filter_score, v.back().score);
 	}
 
 	static bool comp_evalue(const Target &t, const Target& u) {
@@ -113,7 +114,7 @@ struct Target {
 	int filter_score;
 	double filter_evalue;
 	int ungapped_score;
-	std::array<std::list<Hsp>, MAX_CONTEXT> hsp;
+	std::array<std::vector<Hsp>, MAX_CONTEXT> hsp;
 	Stats::TargetMatrix matrix;
 };
 
@@ -135,10 +136,12 @@ struct TargetScore {
 void culling(std::vector<Target>& targets, int source_query_len, const char* query_title, const Sequence& query_seq, size_t min_keep, const Block& target_block);
 bool append_hits(std::vector<Target>& targets, std::vector<Target>::const_iterator begin, std::vector<Target>::const_iterator end, size_t chunk_size, int source_query_len, const char* query_title, const Sequence& query_seq, const Block& target_block);
 std::vector<WorkTarget> gapped_filter(const Sequence *query, const Bias_correction* query_cbs, std::vector<WorkTarget>& targets, Statistics &stat);
-void gapped_filter(const Sequence* query, const Bias_correction* query_cbs, FlatArray<SeedHit> &seed_hits, std::vector<uint32_t> &target_block_ids, Statistics& stat, int flags, const Search::Config &params);
-std::vector<Target> align(const std::vector<WorkTarget> &targets, const Sequence *query_seq, const Bias_correction *query_cb, int source_query_len, int flags, Statistics &stat);
-std::vector<Match> align(std::vector<Target> &targets, const Sequence *query_seq, const Bias_correction *query_cb, int source_query_len, int flags, Statistics &stat);
-std::vector<Target> full_db_align(const Sequence *query_seq, const Bias_correction *query_cb, int flags, Statistics &stat, const Block& target_block);
+void gapped_filter(const Sequence* query, const Bias_correction* query_cbs, QueryProfiles& profiles, FlatArray<SeedHit> &seed_hits, std::vector<uint32_t> &target_block_ids, Statistics& stat, int flags, const Search::Config &params);
+std::vector<Target> align(const std::vector<WorkTarget> &targets, const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int source_query_len, int flags, Statistics &stat);
+std::vector<Match> align(std::vector<Target> &targets, const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int source_query_len, int flags, Statistics &stat);
+std::vector<Target> align_frameshift(const std::vector<WorkTarget>& targets, const TranslatedSequence& query, int source_query_len, int flags);
+std::vector<Match> align_frameshift(std::vector<Target>& targets, const TranslatedSequence& query, int source_query_len, int flags);
+std::vector<Target> full_db_align(const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, int flags, Statistics &stat, const Block& target_block);
 
 std::vector<Match> extend(
 	size_t query_id,
@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../stats/hauser_correction.h"
 #include "target.h"
 #include "../dp/ungapped.h"
+#include "../dp/ungapped_simd.h"
 #include "target.h"
 #include "../data/reference.h"
 #include "../util/log_stream.h"
@@ -38,9 +39,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 using std::array;
 using std::vector;
-using std::list;
 using std::atomic;
 using std::mutex;
+using std::pair;
 
 namespace Extension {
 
@@ -82,12 +83,74 @@ WorkTarget::WorkTarget(size_t block_id, const Sequence& seq, int query_len, cons
 		matrix = Stats::TargetMatrix(query_comp, query_len, seq);
 }
 
-WorkTarget ungapped_stage(FlatArray<SeedHit>::Iterator begin, FlatArray<SeedHit>::Iterator end, const Sequence *query_seq, const Bias_correction *query_cb, const Stats::Composition& query_comp, const int16_t** query_matrix, uint32_t block_id, Statistics& stat, const Block& targets) {
+// Extends the sorted seed hits of one frame. Each diagonal is a lane of the batched x-drop kernel, hits that are
+// covered by the previous segment on the same diagonal are skipped.
+static void extend_seed_hits(FlatArray<SeedHit>::Iterator begin, FlatArray<SeedHit>::Iterator end, unsigned frame, const Sequence& query, const Sequence& subject, vector<Diagonal_segment>& out) {
+	constexpr int BATCH = 16;
+	struct Lane {
+		size_t hit, end;
+		uint32_t run;
+		bool extended;
+		Diagonal_segment last;
+	};
+	thread_local vector<const SeedHit*> hits;
+	thread_local vector<pair<uint32_t, Diagonal_segment>> segments;
+	hits.clear();
+	segments.clear();
+	for (FlatArray<SeedHit>::Iterator i = begin; i < end; ++i)
+		if (i->frame == frame)
+			hits.push_back(&*i);
+	if (hits.empty())
+		return;
+
+	Lane lanes[BATCH];
+	int lane_count = 0, qa[BATCH], sa[BATCH];
+	Diagonal_segment d[BATCH];
+	size_t next = 0;
+	uint32_t run = 0;
+	for (;;) {
+		while (lane_count < BATCH && next < hits.size()) {
+			size_t run_end = next + 1;
+			while (run_end < hits.size() && hits[run_end]->diag() == hits[next]->diag())
+				++run_end;
+			lanes[lane_count++] = { next, run_end, run++, false, Diagonal_segment() };
+			next = run_end;
+		}
+		if (lane_count == 0)
+			break;
+		for (int i = 0; i < lane_count; ++i) {
+			qa[i] = hits[lanes[i].hit]->i;
+			sa[i] = hits[lanes[i].hit]->j;
+		}
+		DP::xdrop_ungapped_batch(query, subject, qa, sa, lane_count, d);
+		int n = 0;
+		for (int i = 0; i < lane_count; ++i) {
+			Lane l = lanes[i];
+			if (d[i].score > 0) {
+				segments.emplace_back(l.run, d[i]);
+				l.last = d[i];
+				l.extended = true;
+			}
+			do
+				++l.hit;
+			while (l.hit < l.end && l.extended && l.last.subject_end() >= hits[l.hit]->j);
+			if (l.hit < l.end)
+				lanes[n++] = l;
+		}
+		lane_count = n;
+	}
+
+	std::stable_sort(segments.begin(), segments.end(), [](const pair<uint32_t, Diagonal_segment>& a, const pair<uint32_t, Diagonal_segment>& b) { return a.first < b.first; });
+	for (const pair<uint32_t, Diagonal_segment>& s : segments)
+		out.push_back(s.second);
+}
+
+WorkTarget ungapped_stage(FlatArray<SeedHit>::Iterator begin, FlatArray<SeedHit>::Iterator end, const Sequence *query_seq, const Bias_correction *query_cb, const QueryProfiles& profiles, const Stats::Composition& query_comp, const int16_t** query_matrix, uint32_t block_id, Statistics& stat, const Block& targets) {
 	array<vector<Diagonal_segment>, MAX_CONTEXT> diagonal_segments;
 	task_timer timer;
 	const SequenceSet& ref_seqs = targets.seqs(), &ref_seqs_unmasked = targets.unmasked_seqs();
 	const bool masking = config.comp_based_stats == Stats::CBS::COMP_BASED_STATS_AND_MATRIX_ADJUST ? Stats::use_seg_masking(query_seq[0], ref_seqs_unmasked[block_id]) : true;
-	WorkTarget target(block_id, masking ? ref_seqs[block_id] : ref_seqs_unmasked[block_id], Stats::count_true_aa(query_seq[0]), query_comp, query_matrix);
+	WorkTarget target(block_id, masking ? ref_seqs[block_id] : ref_seqs_unmasked[block_id], profiles.true_aa, query_comp, query_matrix);
 	stat.inc(Statistics::TIME_MATRIX_ADJUST, timer.microseconds());
 	if (!Stats::CBS::avg_matrix(config.comp_based_stats) && target.adjusted_matrix())
 		stat.inc(Statistics::MATRIX_ADJUST_COUNT);
@@ -97,36 +160,39 @@ WorkTarget ungapped_stage(FlatArray<SeedHit>::Iterator begin, FlatArray<SeedHit>
 			target.ungapped_score[hit->frame] = std::max(target.ungapped_score[hit->frame], hit->score);
 		return target;
 	}
+	// chaining is frame-local, so frameshift alignments are banded around the raw seed diagonals
+	if (config.frame_shift) {
+		for (FlatArray<SeedHit>::Iterator hit = begin; hit < end; ++hit) {
+			target.ungapped_score[hit->frame] = std::max(target.ungapped_score[hit->frame], hit->score);
+			target.hsp[hit->frame].emplace_back(hit->diag(), hit->diag(), hit->score, hit->frame, interval(), interval());
+		}
+		return target;
+	}
 	if (end - begin == 1 && align_mode.query_translated) {
 		target.ungapped_score[begin->frame] = begin->score;
 		target.hsp[begin->frame].emplace_back(begin->diag(), begin->diag(), begin->score, begin->frame, interval(), interval());
 		return target;
 	}
 	std::sort(begin, end);
-	for (FlatArray<SeedHit>::Iterator hit = begin; hit < end; ++hit) {
+	for (FlatArray<SeedHit>::Iterator hit = begin; hit < end; ++hit)
 		target.ungapped_score[hit->frame] = std::max(target.ungapped_score[hit->frame], hit->score);
-		if (!diagonal_segments[hit->frame].empty() && diagonal_segments[hit->frame].back().diag() == hit->diag() && diagonal_segments[hit->frame].back().subject_end() >= hit->j)
-			continue;
-		const Diagonal_segment d = xdrop_ungapped(query_seq[hit->frame], target.seq, hit->i, hit->j);
-		if (d.score > 0) {
-			diagonal_segments[hit->frame].push_back(d);
-		}
-	}
+	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame)
+		extend_seed_hits(begin, end, frame, query_seq[frame], target.seq, diagonal_segments[frame]);
 	for (unsigned frame = 0; frame < align_mode.query_contexts; ++frame) {
 		if (diagonal_segments[frame].empty())
 			continue;
 		std::stable_sort(diagonal_segments[frame].begin(), diagonal_segments[frame].end(), Diagonal_segment::cmp_diag);
-		pair<int, list<Hsp_traits>> hsp = greedy_align(query_seq[frame], target.seq, diagonal_segments[frame].begin(), diagonal_segments[frame].end(), config.log_extend, frame);
+		pair<int, vector<Hsp_traits>> hsp = greedy_align(query_seq[frame], target.seq, diagonal_segments[frame].begin(), diagonal_segments[frame].end(), config.log_extend, frame);
 		target.hsp[frame] = std::move(hsp.second);
-		target.hsp[frame].sort(Hsp_traits::cmp_diag);
+		std::stable_sort(target.hsp[frame].begin(), target.hsp[frame].end(), Hsp_traits::cmp_diag);
 	}
 	return target;
 }
 
-void ungapped_stage_worker(size_t i, size_t thread_id, const Sequence *query_seq, const Bias_correction *query_cb, const Stats::Composition* query_comp, FlatArray<SeedHit> *seed_hits, const uint32_t* target_block_ids, vector<WorkTarget> *out, mutex *mtx, Statistics* stat, const Block* targets) {
+void ungapped_stage_worker(size_t i, size_t thread_id, const Sequence *query_seq, const Bias_correction *query_cb, const QueryProfiles* profiles, const Stats::Composition* query_comp, FlatArray<SeedHit> *seed_hits, const uint32_t* target_block_ids, vector<WorkTarget> *out, mutex *mtx, Statistics* stat, const Block* targets) {
 	Statistics stats;
 	const int16_t* query_matrix = nullptr;
-	WorkTarget target = ungapped_stage(seed_hits->begin(i), seed_hits->end(i), query_seq, query_cb, *query_comp, &query_matrix, target_block_ids[i], stats, *targets);
+	WorkTarget target = ungapped_stage(seed_hits->begin(i), seed_hits->end(i), query_seq, query_cb, *profiles, *query_comp, &query_matrix, target_block_ids[i], stats, *targets);
 	{
 		std::lock_guard<mutex> guard(*mtx);
 		out->push_back(std::move(target));
@@ -135,7 +201,7 @@ void ungapped_stage_worker(size_t i, size_t thread_id, const Sequence *query_seq
 	delete[] query_matrix;
 }
 
-vector<WorkTarget> ungapped_stage(const Sequence *query_seq, const Bias_correction *query_cb, const Stats::Composition& query_comp, FlatArray<SeedHit> &seed_hits, const vector<uint32_t>& target_block_ids, int flags, Statistics& stat, const Block& target_block) {
+vector<WorkTarget> ungapped_stage(const Sequence *query_seq, const Bias_correction *query_cb, QueryProfiles& profiles, const Stats::Composition& query_comp, FlatArray<SeedHit> &seed_hits, const vector<uint32_t>& target_block_ids, int flags, Statistics& stat, const Block& target_block) {
 	vector<WorkTarget> targets;
 	if (target_block_ids.size() == 0)
 		return targets;
@@ -143,11 +209,11 @@ vector<WorkTarget> ungapped_stage(const Sequence *query_seq, const Bias_correcti
 	const int16_t* query_matrix = nullptr;
 	if (flags & DP::PARALLEL) {
 		mutex mtx;
-		Util::Parallel::scheduled_thread_pool_auto(config.threads_, seed_hits.size(), ungapped_stage_worker, query_seq, query_cb, &query_comp, &seed_hits, target_block_ids.data(), &targets, &mtx, &stat, &target_block);
+		Util::Parallel::scheduled_thread_pool_auto(config.threads_, seed_hits.size(), ungapped_stage_worker, query_seq, query_cb, &profiles, &query_comp, &seed_hits, target_block_ids.data(), &targets, &mtx, &stat, &target_block);
 	}
 	else {
 		for (size_t i = 0; i < target_block_ids.size(); ++i)
-			targets.push_back(ungapped_stage(seed_hits.begin(i), seed_hits.end(i), query_seq, query_cb, query_comp, &query_matrix, target_block_ids[i], stat, target_block));
+			targets.push_back(ungapped_stage(seed_hits.begin(i), seed_hits.end(i), query_seq, query_cb, profiles, query_comp, &query_matrix, target_block_ids[i], stat, target_block));
 	}
 
 	delete[] query_matrix;
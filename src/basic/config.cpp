@@ -262,22 +262,32 @@ Config::Config(int argc, const char **argv, bool check_io)
 		("in", 0, "input reference file in FASTA format", input_ref_file)
 		("taxonmap", 0, "protein accession to taxid mapping file", prot_accession2taxid)
 		("taxonnodes", 0, "taxonomy nodes.dmp from NCBI", nodesdmp)
-		("taxonnames", 0, "taxonomy names.dmp from NCBI", namesdmp);
+		("taxonnames", 0, "taxonomy names.dmp from NCBI", namesdmp)
+		("accession-index", 0, "write an accession index to support --seqidlist", accession_index)
+		("freq-table", 0, "write a database-wide seed frequency table for masking frequent seeds", freq_table);
 
 	Options_group cluster("");
 	cluster.add()
 		("cluster-algo", 0, "Clustering algorithm (\"multi-step\", \"mcl\")", cluster_algo)
-		("cluster-steps", 0, "Clustering steps (\"fast\",\"mid-sensitive\",\"sensitive\", \"more-sensitive\", \"very-sensitive\", \"ultra-sensitive\")", cluster_steps, { "sensitive" })
+		("cluster-steps", 0, "Clustering steps (\"kmer\", \"fast\",\"mid-sensitive\",\"sensitive\", \"more-sensitive\", \"very-sensitive\", \"ultra-sensitive\")", cluster_steps, { "sensitive" })
+		("kmer-cluster-id", 0, "Minimum identity% of the k-mer clustering step (default=90)", cluster_kmer_id, 90.0)
 		("max-size-set", 0, "Maximum size of a set", max_size_set, (size_t) 1000)
 		("external", 0, "save set of edges external", external, false)
 		("cluster-similarity", 0, "Clustering similarity measure", cluster_similarity)
 		("cluster-graph-file", 0, "Filename for dumping the graph or reading the graph if cluster-restart", cluster_graph_file)
 		("cluster-restart", 0, "Restart clustering from dumped graph", cluster_restart)
+		("cover-rounds", 0, "Select the centroids in parallel rounds of local maxima (deterministic, may differ from the serial greedy order)", cluster_cover_rounds)
+		("previous-clusters", 0, "Membership table of a previous clustering with the representatives given by --db, to be extended by the sequences given by --query", cluster_previous)
+		("new-reps", 0, "Output file for the new representatives found by incremental clustering (FASTA)", cluster_new_reps)
 		("mcl-expansion", 0, "MCL expansion coefficient (default=2)", cluster_mcl_expansion, (uint32_t) 2)
 		("mcl-inflation", 0, "MCL inflation coefficient (default=2.0)", cluster_mcl_inflation, 2.0)
 		("mcl-chunk-size", 0, "MCL chunk size per thread (default=100)", cluster_mcl_chunk_size, (uint32_t) 1)
 		("mcl-max-iterations", 0, "MCL maximum iterations (default=100)", cluster_mcl_max_iter, (uint32_t) 100)
 		("mcl-sparsity-switch", 0, "MCL switch to sparse matrix computation (default=0.8) ", cluster_mcl_sparsity_switch, 0.8)
+		("mcl-prune-threshold", 0, "MCL threshold for pruning expanded matrix entries (default=1e-4)", cluster_mcl_prune_threshold, 1e-4)
+		("mcl-select", 0, "MCL maximum number of entries kept per column after pruning (default=1100)", cluster_mcl_select, (uint32_t) 1100)
+		("mcl-recover", 0, "MCL maximum number of entries recovered per column (default=1400)", cluster_mcl_recover, (uint32_t) 1400)
+		("mcl-recover-pct", 0, "MCL column mass in percent below which pruned entries are recovered (default=90)", cluster_mcl_recover_pct, 90.0)
 		("mcl-nonsymmetric", 0, "Do not symmetrize the transistion matrix before clustering", cluster_mcl_nonsymmetric)
 		("mcl-stats", 0, "Some stats about the connected components in MCL", cluster_mcl_stats);
 
@@ -310,6 +320,8 @@ Config::Config(int argc, const char **argv, bool check_io)
 		("global-ranking", 'g', "number of targets for global ranking", global_ranking_targets)
 		("block-size", 'b', "sequence block size in billions of letters (default=2.0)", chunk_size)
 		("index-chunks", 'c', "number of chunks for index processing (default=4)", lowmem_)
+		("numa", 0, "NUMA-aware placement of seed arrays and search threads", numa)
+		("autotune", 0, "calibrate internal search parameters for this host (cached in $HOME/.diamond_autotune)", autotune)
 		("tmpdir", 't', "directory for temporary files", tmpdir)
 		("parallel-tmpdir", 0, "directory for temporary files used by multiprocessing", parallel_tmpdir)
 		("gapopen", 0, "gap open penalty", gap_open, -1)
@@ -335,6 +347,7 @@ Config::Config(int argc, const char **argv, bool check_io)
 	advanced.add()
 		("algo", 0, "Seed search algorithm (0=double-indexed/1=query-indexed/ctg=contiguous-seed)", algo_str)
 		("bin", 0, "number of query bins for seed search", query_bins_)
+		("subsample-seeds", 0, "index only the reference seeds at closed syncmer positions (--fast)", subsample_seeds)
 		("min-orf", 'l', "ignore translated sequences without an open reading frame of at least this length", run_len)
 		("freq-sd", 0, "number of standard deviations for ignoring frequent seeds", freq_sd_, 0.0)
 		("id2", 0, "minimum number of identities for stage 1 hit", min_identities_)
@@ -360,6 +373,7 @@ Config::Config(int argc, const char **argv, bool check_io)
 		("tantan-minMaskProb", 0, "minimum repeat probability for masking (default=0.9)", tantan_minMaskProb, 0.9)
 		("file-buffer-size", 0, "file buffer size in bytes (default=67108864)", file_buffer_size, (size_t)67108864)
 		("memory-limit", 'M', "Memory limit for extension stage in GB", memory_limit)
+		("traceback-checkpoint-dp", 0, "DP matrix size (band x length) above which the traceback is recomputed from checkpoints to bound memory use (default=25000000)", traceback_checkpoint_dp, (size_t)25000000)
 		("no-unlink", 0, "Do not unlink temporary files.", no_unlink)
 		("target-indexed", 0, "Enable target-indexed mode", target_indexed)
 		("ignore-warnings", 0, "Ignore warnings", ignore_warnings)
@@ -448,7 +462,7 @@ Config::Config(int argc, const char **argv, bool check_io)
 		("radix-cluster-buffered", 0, "", radix_cluster_buffered)
 		("join-split-size", 0, "", join_split_size, 100000u)
 		("join-split-key-len", 0, "", join_split_key_len, 17u)
-		("radix-bits", 0, "", radix_bits, 8u)
+		("radix-bits", 0, "", radix_bits)
 		("join-ht-factor", 0, "", join_ht_factor, 1.3)
 		("sort-join", 0, "", sort_join)
 		("simple-freq", 0, "", simple_freq)
@@ -486,7 +500,7 @@ Config::Config(int argc, const char **argv, bool check_io)
 		("col-bin", 0, "", col_bin, 400)
 		("self", 0, "", self)
 		("trace-pt-fetch-size", 0, "", trace_pt_fetch_size, (size_t)10e9)
-		("tile-size", 0, "", tile_size, (size_t)1024)
+		("tile-size", 0, "", tile_size)
 		("short-query-ungapped-bitscore", 0, "", short_query_ungapped_bitscore, 25.0)
 		("short-query-max-len", 0, "", short_query_max_len, 60)
 		("gapped-filter-evalue1", 0, "", gapped_filter_evalue1, 2000.0)
@@ -752,6 +766,12 @@ Config::Config(int argc, const char **argv, bool check_io)
 		log_stream << "L3 cache size: " << l3_cache_size() << endl;
 	}
 
+	// left unset for Search::autotune
+	if (!autotune) {
+		set_option(tile_size, (size_t)1024);
+		set_option(radix_bits, 8u);
+	}
+
 	sensitivity = Sensitivity::DEFAULT;
 	if (mode_fast) set_sens(Sensitivity::FAST);
 	if (mode_mid_sensitive) set_sens(Sensitivity::MID_SENSITIVE);
@@ -123,6 +123,7 @@ struct Config
 	unsigned id_left, id_right, id_n;
 	int bmatch, bmismatch, bcutoff;
 	unsigned query_bins_;
+	bool subsample_seeds;
 	uint64_t n_ants;
 	double rho;
 	double p_best;
@@ -132,6 +133,8 @@ struct Config
 	double path_cutoff;
 	bool use_smith_waterman;
 	string prot_accession2taxid;
+	bool accession_index;
+	bool freq_table;
 	int superblock;
 	unsigned max_cells;
 	int masking;
@@ -212,6 +215,8 @@ struct Config
 	bool self;
 	size_t trace_pt_fetch_size;
 	size_t tile_size;
+	bool numa;
+	bool autotune;
 	double short_query_ungapped_bitscore;
 	int short_query_max_len;
 	double gapped_filter_evalue1;
@@ -259,6 +264,7 @@ struct Config
 	double log_evalue_scale;
 	double ungapped_evalue_short_;
 	size_t max_swipe_dp;
+	size_t traceback_checkpoint_dp;
 	std::string seqidlist;
 	bool skip_missing_seqids;
 	string_vector iterate;
@@ -287,14 +293,22 @@ struct Config
 	string cluster_algo;
 	string cluster_similarity;
 	string cluster_graph_file;
+	string cluster_previous;
+	string cluster_new_reps;
 	bool cluster_restart;
+	bool cluster_cover_rounds;
 
 	size_t max_size_set;
 	bool external;
 	string_vector cluster_steps;
+	double cluster_kmer_id;
 	double cluster_mcl_inflation;
 	uint32_t cluster_mcl_expansion;
 	double cluster_mcl_sparsity_switch;
+	double cluster_mcl_prune_threshold;
+	uint32_t cluster_mcl_select;
+	uint32_t cluster_mcl_recover;
+	double cluster_mcl_recover_pct;
 	uint32_t cluster_mcl_chunk_size;
 	uint32_t cluster_mcl_max_iter;
 	bool cluster_mcl_stats;
@@ -207,8 +207,25 @@ struct Hsp
 	}
 
 	bool is_enveloped_by(const Hsp &hsp, double p) const;
-	bool is_enveloped_by(std::list<Hsp>::const_iterator begin, std::list<Hsp>::const_iterator end, double p) const;
-	bool is_weakly_enveloped_by(std::list<Hsp>::const_iterator begin, std::list<Hsp>::const_iterator end, int cutoff) const;
+
+	template<typename _it>
+	bool is_enveloped_by(_it begin, _it end, double p) const
+	{
+		for (_it i = begin; i != end; ++i)
+			if (is_enveloped_by(*i, p))
+				return true;
+		return false;
+	}
+
+	template<typename _it>
+	bool is_weakly_enveloped_by(_it begin, _it end, int cutoff) const
+	{
+		for (_it i = begin; i != end; ++i)
+			if (partial_score(*i) < cutoff)
+				return true;
+		return false;
+	}
+
 	void push_back(const DiagonalSegment &d, const TranslatedSequence &query, const Sequence& subject, bool reversed);
 	void push_match(Letter q, Letter s, bool positive);
 	void push_gap(Edit_operation op, int length, const Letter *subject);
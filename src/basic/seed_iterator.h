@@ -25,11 +25,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util/hash_function.h"
 #include "../util/algo/MurmurHash3.h"
 
+// Computes for each position of a reduced sequence the number of letters up to the next masked letter, once for all
+// shapes. Windows that fit into such a run are built without checking the letters.
+static inline void unmasked_runs(const vector<Letter> &seq, vector<uint32_t> &runs)
+{
+	runs.resize(seq.size());
+	uint32_t n = 0;
+	for (size_t i = seq.size(); i > 0; --i) {
+		n = letter_mask(seq[i - 1]) == value_traits.mask_char ? 0 : n + 1;
+		runs[i - 1] = n;
+	}
+}
+
 struct Seed_iterator
 {
-	Seed_iterator(vector<Letter> &seq, const Shape &sh):
+	Seed_iterator(vector<Letter> &seq, const vector<uint32_t> &runs, const Shape &sh):
 		ptr_ (seq.data()),
-		end_ (ptr_ + seq.size() - sh.length_ + 1)
+		end_ (ptr_ + seq.size() - sh.length_ + 1),
+		run_ (runs.data())
 	{}
 	bool good() const
 	{
@@ -37,10 +50,15 @@ struct Seed_iterator
 	}
 	bool get(uint64_t &seed, const Shape &sh)
 	{
+		if (*(run_++) >= sh.length_) {
+			seed = sh.seed_reduced(ptr_++);
+			return true;
+		}
 		return sh.set_seed_reduced(seed, ptr_++);
 	}
 private:
 	const Letter *ptr_, *end_;
+	const uint32_t *run_;
 };
 
 template<uint64_t _b>
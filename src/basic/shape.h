@@ -132,6 +132,15 @@ struct Shape
 		return true;
 	}
 
+	// set_seed_reduced for a window known to contain no masked letter
+	inline Packed_seed seed_reduced(const Letter *seq) const
+	{
+		Packed_seed s = 0;
+		for (unsigned i = 0; i < weight_; ++i)
+			s = s * Reduction::reduction.size() + uint64_t(letter_mask(seq[positions_[i]]));
+		return s;
+	}
+
 	inline bool set_seed(Seed &s, const Letter *seq) const
 	{
 		for (unsigned i = 0; i < weight_; ++i) {
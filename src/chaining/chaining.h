@@ -23,7 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../dp/hsp_traits.h"
 #include "../stats/hauser_correction.h"
 
-std::pair<int, std::list<Hsp_traits>> greedy_align(Sequence query, Sequence subject, std::vector<Diagonal_segment>::const_iterator begin, std::vector<Diagonal_segment>::const_iterator end, bool log, unsigned frame);
+std::pair<int, std::vector<Hsp_traits>> greedy_align(Sequence query, Sequence subject, std::vector<Diagonal_segment>::const_iterator begin, std::vector<Diagonal_segment>::const_iterator end, bool log, unsigned frame);
 
 struct Diagonal_node : public Diagonal_segment
 {
@@ -39,7 +39,7 @@ using std::map;
 using std::list;
 using std::set;
 
-bool disjoint(list<Hsp_traits>::const_iterator begin, list<Hsp_traits>::const_iterator end, const Hsp_traits &t, int cutoff)
+bool disjoint(vector<Hsp_traits>::const_iterator begin, vector<Hsp_traits>::const_iterator end, const Hsp_traits &t, int cutoff)
 {
 	for (; begin != end; ++begin)
 		if (begin->partial_score(t) < cutoff || !begin->collinear(t))
@@ -49,7 +49,7 @@ bool disjoint(list<Hsp_traits>::const_iterator begin, list<Hsp_traits>::const_it
 	return true;
 }
 
-bool disjoint(list<Hsp_traits>::const_iterator begin, list<Hsp_traits>::const_iterator end, const Diagonal_segment &d, int cutoff)
+bool disjoint(vector<Hsp_traits>::const_iterator begin, vector<Hsp_traits>::const_iterator end, const Diagonal_segment &d, int cutoff)
 {
 	for (; begin != end; ++begin)
 		if (begin->partial_score(d) < cutoff || !begin->collinear(d))
@@ -491,7 +491,7 @@ struct Greedy_aligner2
 		t = traits;
 	}
 
-	int backtrace(size_t top_node, list<Hsp> &hsps, list<Hsp_traits> &ts, list<Hsp_traits>::iterator &t_begin, int cutoff, int max_shift) const
+	int backtrace(size_t top_node, list<Hsp> &hsps, vector<Hsp_traits> &ts, size_t t_begin, int cutoff, int max_shift) const
 	{
 		unsigned next;
 		int max_score = 0, max_j = (int)subject.length();
@@ -502,14 +502,8 @@ struct Greedy_aligner2
 			backtrace(top_node, hsp, t, max_shift, next, max_j);
 			if (t.score > 0)
 				max_j = t.subject_range.begin_;
-			if (t.score >= cutoff && disjoint(t_begin, ts.end(), t, cutoff)) {
-				if (t_begin == ts.end()) {
-					ts.push_back(t);
-					t_begin = ts.end();
-					t_begin--;
-				}
-				else
-					ts.push_back(t);
+			if (t.score >= cutoff && disjoint(ts.cbegin() + t_begin, ts.cend(), t, cutoff)) {
+				ts.push_back(t);
 				if (hsp)
 					hsps.push_back(*hsp);
 				max_score = std::max(max_score, t.score);
@@ -520,7 +514,7 @@ struct Greedy_aligner2
 		return max_score;
 	}
 
-	int backtrace(list<Hsp> &hsps, list<Hsp_traits> &ts, int cutoff, int max_shift) const
+	int backtrace(list<Hsp> &hsps, vector<Hsp_traits> &ts, int cutoff, int max_shift) const
 	{
 		vector<Diagonal_node*> top_nodes;
 		for (size_t i = 0; i < diags.nodes.size(); ++i) {
@@ -532,13 +526,13 @@ struct Greedy_aligner2
 		}
 		std::sort(top_nodes.begin(), top_nodes.end(), Diagonal_node::cmp_rel_score);
 		int max_score = 0;
-		list<Hsp_traits>::iterator t_begin = ts.end();
+		const size_t t_begin = ts.size();
 
 		for (vector<Diagonal_node*>::const_iterator i = top_nodes.begin(); i < top_nodes.end(); ++i) {
 			const size_t node = *i - diags.nodes.data();
 			if (log)
 				cout << "Backtrace candidate node=" << node << endl;
-			if (disjoint(t_begin, ts.end(), **i, cutoff)) {
+			if (disjoint(ts.cbegin() + t_begin, ts.cend(), **i, cutoff)) {
 				if (log)
 					cout << "Backtrace node=" << node << " prefix_score=" << (*i)->prefix_score << " rel_score=" << (*i)->rel_score() << endl;
 				max_score = std::max(max_score, backtrace(node, hsps, ts, t_begin, cutoff, max_shift));
@@ -549,7 +543,7 @@ struct Greedy_aligner2
 		return max_score;
 	}
 
-	int run(list<Hsp> &hsps, list<Hsp_traits> &ts, double space_penalty, int cutoff, int max_shift)
+	int run(list<Hsp> &hsps, vector<Hsp_traits> &ts, double space_penalty, int cutoff, int max_shift)
 	{
 		if (config.chaining_maxnodes > 0) {
 			std::sort(diags.nodes.begin(), diags.nodes.end(), Diagonal_segment::cmp_score);
@@ -588,7 +582,7 @@ struct Greedy_aligner2
 		return max_score;
 	}
 
-	int run(list<Hsp> &hsps, list<Hsp_traits> &ts, vector<Diagonal_segment>::const_iterator begin, vector<Diagonal_segment>::const_iterator end, int band)
+	int run(list<Hsp> &hsps, vector<Hsp_traits> &ts, vector<Diagonal_segment>::const_iterator begin, vector<Diagonal_segment>::const_iterator end, int band)
 	{
 		if (log)
 			cout << "***** Seed hit run " << begin->diag() << '\t' << (end - 1)->diag() << '\t' << (end - 1)->diag() - begin->diag() << endl;
@@ -618,14 +612,14 @@ struct Greedy_aligner2
 thread_local Diag_graph Greedy_aligner2::diags;
 thread_local map<int, unsigned> Greedy_aligner2::window;
 
-std::pair<int, list<Hsp_traits>> greedy_align(Sequence query, Sequence subject, vector<Diagonal_segment>::const_iterator begin, vector<Diagonal_segment>::const_iterator end, bool log, unsigned frame)
+std::pair<int, vector<Hsp_traits>> greedy_align(Sequence query, Sequence subject, vector<Diagonal_segment>::const_iterator begin, vector<Diagonal_segment>::const_iterator end, bool log, unsigned frame)
 {
 	const int band = config.chaining_maxgap;
 	if (end - begin == 1)
 		return { begin->score, { { begin->diag(), begin->diag(), begin->score, (int)frame, begin->query_range(), begin->subject_range() } } };
 	Greedy_aligner2 ga(query, subject, log, frame);
 	list<Hsp> hsps;
-	list<Hsp_traits> ts;
+	vector<Hsp_traits> ts;
 	int score = ga.run(hsps, ts, begin, end, band);
 	return std::make_pair(score, std::move(ts));
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <atomic>
 
 #pragma once
 
@@ -255,3 +256,72 @@ public:
 		nodes.clear();
 	}
 };
+
+// Lock-free union-find over the integers [0, n) that supports concurrent merges.
+// Uses path halving in getRoot and union by rank, where links are installed by compare-and-swap on the root.
+template<typename T> class ConcurrentDisjointSet {
+private:
+	vector<atomic<T>> parent;
+	vector<atomic<uint8_t>> rank;
+
+public:
+	static_assert(std::is_integral<T>::value, "T needs to be an integral type");
+
+	ConcurrentDisjointSet<T>(size_t size):
+		parent(size),
+		rank(size)
+	{
+		for (size_t i = 0; i < size; ++i) {
+			parent[i].store((T)i, memory_order_relaxed);
+			rank[i].store(0, memory_order_relaxed);
+		}
+	}
+
+	T getRoot(T x) {
+		for (;;) {
+			T p = parent[x].load(memory_order_relaxed);
+			if (p == x)
+				return x;
+			const T gp = parent[p].load(memory_order_relaxed);
+			if (p != gp)
+				parent[x].compare_exchange_weak(p, gp, memory_order_relaxed);
+			x = gp;
+		}
+	}
+
+	void merge(T x, T y) {
+		for (;;) {
+			x = getRoot(x);
+			y = getRoot(y);
+			if (x == y)
+				return;
+			uint8_t rx = rank[x].load(memory_order_relaxed), ry = rank[y].load(memory_order_relaxed);
+			if (rx > ry || (rx == ry && x < y)) {
+				swap(x, y);
+				swap(rx, ry);
+			}
+			// x is linked below y, fails if another thread has linked x in the meantime
+			T expected = x;
+			if (!parent[x].compare_exchange_strong(expected, y))
+				continue;
+			if (rx == ry)
+				rank[y].compare_exchange_strong(ry, (uint8_t)(ry + 1));
+			return;
+		}
+	}
+
+	vector<unordered_set<T>> getListOfSets() {
+		const T n = (T)parent.size();
+		vector<T> set_id(n, numeric_limits<T>::max());
+		vector<unordered_set<T>> listOfSets;
+		for (T i = 0; i < n; i++) {
+			const T r = getRoot(i);
+			if (set_id[r] == numeric_limits<T>::max()) {
+				set_id[r] = (T)listOfSets.size();
+				listOfSets.emplace_back();
+			}
+			listOfSets[set_id[r]].insert(i);
+		}
+		return listOfSets;
+	}
+};
@@ -0,0 +1,207 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2013-2018 Benjamin Buchfink <buchfink@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include "multi_step_cluster.h"
+#include "../util/hash_function.h"
+#include "../basic/reduction.h"
+#include "../align/target.h"
+#define _REENTRANT
+#include "../lib/ips4o/ips4o.hpp"
+
+using namespace std;
+
+namespace Workflow { namespace Cluster {
+
+// k-mers are taken over the seed reduced alphabet, which has at most 16 letters
+static const int KMER_LEN = 12;
+// number of k-mers with the smallest hash values selected per sequence
+static const size_t KMERS_PER_SEQ = 20;
+static const size_t THREAD_CHUNK = 1024;
+
+// keyed by the k-mer code itself, so that a group of equal keys shares exactly one k-mer
+struct KmerEntry {
+	bool operator<(const KmerEntry& e) const {
+		return key < e.key || (key == e.key && block_id < e.block_id);
+	}
+	uint64_t key;
+	uint32_t block_id;
+	int32_t pos;
+};
+
+struct HashedKmer {
+	bool operator<(const HashedKmer& k) const {
+		return hash < k.hash || (hash == k.hash && (code < k.code || (code == k.code && pos < k.pos)));
+	}
+	uint64_t hash, code;
+	int32_t pos;
+};
+
+struct Candidate {
+	bool operator<(const Candidate& c) const {
+		return member < c.member || (member == c.member && center < c.center);
+	}
+	bool operator==(const Candidate& c) const {
+		return member == c.member && center == c.center;
+	}
+	uint32_t member, center;
+	int32_t diag;
+};
+
+template<typename F>
+static void parallel_chunks(size_t n, F f) {
+	atomic<size_t> next(0);
+	auto worker = [&]() {
+		size_t begin;
+		while ((begin = next.fetch_add(THREAD_CHUNK, memory_order_relaxed)) < n)
+			f(begin, std::min(begin + THREAD_CHUNK, n));
+	};
+	vector<thread> t;
+	for (size_t i = 0; i < std::max(config.threads_, 1u); ++i)
+		t.emplace_back(worker);
+	for (auto& i : t)
+		i.join();
+}
+
+static void select_kmers(const Sequence& seq, uint32_t block_id, vector<HashedKmer>& buf, vector<KmerEntry>& out) {
+	const int len = (int)seq.length();
+	buf.clear();
+	uint64_t code = 0;
+	int valid = 0;
+	for (int i = 0; i < len; ++i) {
+		const Letter l = letter_mask(seq[i]);
+		if (l >= 20) {
+			valid = 0;
+			continue;
+		}
+		code = ((code << 4) | Reduction::reduction(l)) & ((uint64_t(1) << (4 * KMER_LEN)) - 1);
+		if (++valid >= KMER_LEN)
+			buf.push_back({ murmur_hash()(code), code, i - KMER_LEN + 1 });
+	}
+	sort(buf.begin(), buf.end());
+	size_t n = 0;
+	for (size_t i = 0; i < buf.size() && n < KMERS_PER_SEQ; ++i) {
+		if (i > 0 && buf[i].code == buf[i - 1].code)
+			continue;
+		out.push_back({ buf[i].code, block_id, buf[i].pos });
+		++n;
+	}
+}
+
+// Linear-time preclustering of near-identical sequences: sequences sharing one of their selected k-mers are grouped,
+// each member of a group is aligned against the longest sequence of the group only, and the graph of the accepted
+// alignments is covered like the search-based steps.
+vector<int> MultiStep::kmer_cluster(shared_ptr<SequenceFile>& db, const shared_ptr<BitVector>& filter) {
+	if (Reduction::reduction.size() > 16)
+		throw runtime_error("K-mer clustering requires a reduced alphabet of at most 16 letters.");
+	set_search_options();
+	task_timer timer("Loading sequences");
+	db->set_seqinfo_ptr(0);
+	unique_ptr<Block> block(db->load_seqs(numeric_limits<size_t>::max(), false, filter.get()));
+	const SequenceSet& seqs = block->seqs();
+	const size_t n = seqs.size();
+	score_matrix.set_db_letters(config.db_size ? config.db_size : db->letters());
+
+	timer.go("Selecting k-mers");
+	vector<KmerEntry> kmers;
+	mutex mtx;
+	parallel_chunks(n, [&](size_t begin, size_t end) {
+		vector<HashedKmer> buf;
+		vector<KmerEntry> out;
+		for (size_t i = begin; i < end; ++i)
+			select_kmers(seqs[i], (uint32_t)i, buf, out);
+		lock_guard<mutex> lock(mtx);
+		kmers.insert(kmers.end(), out.begin(), out.end());
+	});
+
+	timer.go("Sorting k-mers");
+	ips4o::parallel::sort(kmers.begin(), kmers.end(), std::less<KmerEntry>(), config.threads_);
+
+	timer.go("Grouping sequences");
+	vector<Candidate> candidates;
+	for (auto i = kmers.cbegin(); i < kmers.cend();) {
+		auto j = i + 1;
+		while (j < kmers.cend() && j->key == i->key)
+			++j;
+		if (j - i > 1) {
+			auto center = i;
+			for (auto k = i + 1; k < j; ++k) {
+				const size_t l1 = seqs[k->block_id].length(), l2 = seqs[center->block_id].length();
+				if (l1 > l2 || (l1 == l2 && k->block_id < center->block_id))
+					center = k;
+			}
+			for (auto k = i; k < j; ++k)
+				if (k->block_id != center->block_id)
+					candidates.push_back({ k->block_id, center->block_id, k->pos - center->pos });
+		}
+		i = j;
+	}
+	vector<KmerEntry>().swap(kmers);
+	ips4o::parallel::sort(candidates.begin(), candidates.end(), std::less<Candidate>(), config.threads_);
+	candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+	timer.go("Computing alignments");
+	vector<size_t> member_begin;
+	for (size_t i = 0; i < candidates.size(); ++i)
+		if (i == 0 || candidates[i].member != candidates[i - 1].member)
+			member_begin.push_back(i);
+	member_begin.push_back(candidates.size());
+	vector<char> accepted(candidates.size(), 0);
+	parallel_chunks(member_begin.size() - 1, [&](size_t begin, size_t end) {
+		Statistics stat;
+		vector<DpTarget> targets8, targets16, targets32;
+		for (size_t m = begin; m < end; ++m) {
+			const size_t b = member_begin[m], e = member_begin[m + 1];
+			const Sequence query = seqs[candidates[b].member];
+			const int qlen = (int)query.length(), band = Extension::band(qlen);
+			targets16.clear();
+			targets32.clear();
+			for (size_t i = b; i < e; ++i) {
+				const Sequence target = seqs[candidates[i].center];
+				const int slen = (int)target.length(),
+					d0 = std::max(candidates[i].diag - band, -(slen - 1)),
+					d1 = std::min(candidates[i].diag + 1 + band, qlen);
+				(size_t(d1 - d0) * qlen > config.max_swipe_dp ? targets32 : targets16).emplace_back(target, d0, d1, 0, slen, (int)(i - b), qlen);
+			}
+			const vector<Hsp> hsps = DP::BandedSwipe::swipe(query, targets8, targets16, targets32, nullptr, Frame(0), nullptr, nullptr, DP::TRACEBACK, stat);
+			for (const Hsp& h : hsps) {
+				const Candidate& c = candidates[b + h.swipe_target];
+				if (h.id_percent() >= config.cluster_kmer_id
+					&& h.query_range.length() * 100.0 / qlen >= config.query_cover
+					&& h.subject_cover_percent((unsigned)seqs[c.center].length()) >= config.subject_cover)
+					accepted[b + h.swipe_target] = 1;
+			}
+		}
+	});
+
+	timer.go("Computing vertex cover");
+	vector<vector<int>> neighbors(db->sequence_count());
+	size_t edges = 0;
+	for (size_t i = 0; i < candidates.size(); ++i)
+		if (accepted[i]) {
+			neighbors[block->block_id2oid(candidates[i].member)].push_back((int)block->block_id2oid(candidates[i].center));
+			++edges;
+		}
+	timer.finish();
+	message_stream << "K-mer clustering: #Sequences: " << n << " #Candidate pairs: " << candidates.size() << " #Accepted pairs: " << edges << endl;
+	return Util::Algo::greedy_vertex_cover(neighbors, config.threads_, config.cluster_cover_rounds);
+}
+
+}}
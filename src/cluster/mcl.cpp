@@ -40,67 +40,155 @@ string MCL::get_description() {
 	return "Markov clustering according to doi:10.1137/040608635";
 }
 
-vector<Eigen::Triplet<float>> MCL::sparse_matrix_multiply(Eigen::SparseMatrix<float>* a, Eigen::SparseMatrix<float>* b , uint32_t iThr, uint32_t nThr){
-	uint32_t n_cols = b->cols();
-	uint32_t n_rows = a->rows();
-	std::vector<float> result_col(n_rows, 0.0);
-	vector<Eigen::Triplet<float>> data;
-	for (uint32_t j=0; j<n_cols; ++j) {
-		if(j%nThr == iThr){
-			fill(result_col.begin(), result_col.end(), 0.0);
-			for (Eigen::SparseMatrix<float>::InnerIterator  rhsIt(*b, j); rhsIt; ++rhsIt) {
-				const float y = rhsIt.value();
-				const uint32_t k = rhsIt.row();
-				for (Eigen::SparseMatrix<float>::InnerIterator lhsIt(*a, k); lhsIt; ++lhsIt) {
-					const uint32_t i = lhsIt.row();
-					const float x = lhsIt.value();
-					result_col[i] += x*y;
-				}
+// Computes the columns [col_begin, col_end) of a*b using a hash accumulator sized by the column flops. Each column is
+// pruned as described in doi:10.1137/040608635: entries below the threshold are dropped and at most cluster_mcl_select
+// of them are kept, unless this loses too much of the column mass, in which case the largest entries are recovered up
+// to cluster_mcl_recover. If r > 0 the column is then inflated with exponent r and normalized.
+void MCL::sparse_matrix_multiply(Eigen::SparseMatrix<float>* a, Eigen::SparseMatrix<float>* b, uint32_t col_begin, uint32_t col_end, float r, vector<uint32_t>* col_nnz, vector<pair<uint32_t, float>>* data){
+	const uint32_t EMPTY = numeric_limits<uint32_t>::max();
+	const float threshold = (float)config.cluster_mcl_prune_threshold,
+		recover_mass = (float)(config.cluster_mcl_recover_pct / 100.0);
+	const size_t select = config.cluster_mcl_select, recover = config.cluster_mcl_recover;
+	vector<uint32_t> keys;
+	vector<float> values;
+	vector<pair<uint32_t, float>> col;
+	for (uint32_t j = col_begin; j < col_end; ++j) {
+		size_t flops = 0;
+		for (Eigen::SparseMatrix<float>::InnerIterator rhsIt(*b, j); rhsIt; ++rhsIt)
+			flops += a->col(rhsIt.row()).nonZeros();
+		size_t size = 16;
+		while (size < 2 * min(flops, (size_t)a->rows()))
+			size <<= 1;
+		// small matrices are indexed directly, which cannot collide
+		const bool direct = size >= (size_t)a->rows();
+		const size_t mask = size - 1;
+		keys.assign(size, EMPTY);
+		values.assign(size, 0.0f);
+		for (Eigen::SparseMatrix<float>::InnerIterator rhsIt(*b, j); rhsIt; ++rhsIt) {
+			const float y = rhsIt.value();
+			for (Eigen::SparseMatrix<float>::InnerIterator lhsIt(*a, rhsIt.row()); lhsIt; ++lhsIt) {
+				const uint32_t i = lhsIt.row();
+				size_t h = direct ? i : ((i * 0x9E3779B1u) & mask);
+				while (keys[h] != i && keys[h] != EMPTY)
+					h = (h + 1) & mask;
+				keys[h] = i;
+				values[h] += lhsIt.value() * y;
 			}
-			for (uint32_t i=0; i<n_rows; ++i) {
-				if(abs(result_col[i]) > numeric_limits<float>::epsilon()) {
-					data.emplace_back(i, j, result_col[i]);
+		}
+
+		col.clear();
+		float mass = 0.0f, kept = 0.0f;
+		size_t above = 0;
+		for (size_t h = 0; h < size; ++h)
+			if (keys[h] != EMPTY && values[h] > 0.0f) {
+				col.emplace_back(keys[h], values[h]);
+				mass += values[h];
+				if (values[h] >= threshold) {
+					kept += values[h];
+					++above;
 				}
 			}
+		bool row_order = direct;
+		if (above <= select && kept >= recover_mass * mass)
+			col.erase(remove_if(col.begin(), col.end(), [threshold](const pair<uint32_t, float>& e) { return e.second < threshold; }), col.end());
+		else {
+			sort(col.begin(), col.end(), [](const pair<uint32_t, float>& x, const pair<uint32_t, float>& y) { return x.second > y.second || (x.second == y.second && x.first < y.first); });
+			size_t k = 0;
+			kept = 0.0f;
+			while (k < col.size() && k < select && col[k].second >= threshold)
+				kept += col[k++].second;
+			const size_t max_recover = min(col.size(), recover);
+			while (k < max_recover && kept < recover_mass * mass)
+				kept += col[k++].second;
+			col.resize(k);
+			row_order = false;
+		}
+
+		if (r > 0.0f) {
+			float colSum = 0.0f;
+			for (pair<uint32_t, float>& e : col) {
+				e.second = pow(e.second, r);
+				colSum += e.second;
+			}
+			for (pair<uint32_t, float>& e : col)
+				e.second /= colSum;
 		}
+		col.erase(remove_if(col.begin(), col.end(), [](const pair<uint32_t, float>& e) { return abs(e.second) <= numeric_limits<float>::epsilon(); }), col.end());
+		if (!row_order)
+			sort(col.begin(), col.end());
+		col_nnz->push_back((uint32_t)col.size());
+		data->insert(data->end(), col.begin(), col.end());
 	}
-	return data;
 }
 
-void MCL::get_exp(Eigen::SparseMatrix<float>* in, Eigen::SparseMatrix<float>* out, float r, uint32_t nThr){
+// Splits the columns of a*b into nThr contiguous ranges of about the same number of multiply-adds.
+vector<uint32_t> MCL::partition_by_flops(Eigen::SparseMatrix<float>* a, Eigen::SparseMatrix<float>* b, uint32_t nThr){
+	const uint32_t n_cols = b->cols();
+	vector<uint64_t> flops(n_cols + 1, 0);
+	for (uint32_t j = 0; j < n_cols; ++j) {
+		flops[j + 1] = flops[j];
+		for (Eigen::SparseMatrix<float>::InnerIterator rhsIt(*b, j); rhsIt; ++rhsIt)
+			flops[j + 1] += a->col(rhsIt.row()).nonZeros();
+	}
+	vector<uint32_t> bounds(nThr + 1, n_cols);
+	bounds[0] = 0;
+	for (uint32_t iThr = 1; iThr < nThr; ++iThr)
+		bounds[iThr] = (uint32_t)(lower_bound(flops.begin(), flops.end(), flops.back() * iThr / nThr) - flops.begin());
+	return bounds;
+}
+
+void MCL::get_exp(Eigen::SparseMatrix<float>* in, Eigen::SparseMatrix<float>* out, float r, float inflation, uint32_t nThr){
 	chrono::high_resolution_clock::time_point t = chrono::high_resolution_clock::now();
-	if( r - (int) r == 0 ){
-		// TODO: at some r it may be more beneficial to diagnoalize in and only take the exponents of the eigenvalues
-		*out = *in;
-		for(uint32_t i=1; i<r; i++){ 
-			// Note: this is a workaround for a crash in Eigen
-			vector<Eigen::Triplet<float>> data;
-			std::mutex m;
-			auto mult = [&](const uint32_t iThr){
-				vector<Eigen::Triplet<float>> t_data = sparse_matrix_multiply(in, out, iThr, nThr);
-				m.lock();
-				data.insert(data.end(), t_data.begin(), t_data.end());
-				m.unlock();
-			};
-
-			vector<thread> threads;
-			for(uint32_t iThread = 0; iThread < nThr ; iThread++) {
-				threads.emplace_back(mult, iThread);
-			}
+	if( r - (int) r != 0 ){
+		throw runtime_error(" Eigen does not provide an eigenvalue solver for sparse matrices");
+	}
+	// TODO: at some r it may be more beneficial to diagnoalize in and only take the exponents of the eigenvalues
+	*out = *in;
+	for(uint32_t i=1; i<r; i++){
+		const vector<uint32_t> bounds = partition_by_flops(in, out, nThr);
+		vector<vector<uint32_t>> col_nnz(nThr);
+		vector<vector<pair<uint32_t, float>>> data(nThr);
+		const float r_inflation = i + 1 >= r ? inflation : 0.0f;
+		auto mult = [&](const uint32_t iThr){
+			sparse_matrix_multiply(in, out, bounds[iThr], bounds[iThr + 1], r_inflation, &col_nnz[iThr], &data[iThr]);
+		};
+
+		vector<thread> threads;
+		for(uint32_t iThread = 0; iThread < nThr ; iThread++) {
+			threads.emplace_back(mult, iThread);
+		}
+
+		for(uint32_t iThread = 0; iThread < nThr ; iThread++) {
+			threads[iThread].join();
+		}
 
-			for(uint32_t iThread = 0; iThread < nThr ; iThread++) {
-				threads[iThread].join();
+		// The threads return consecutive column ranges in order, so the compressed storage is filled directly.
+		Eigen::SparseMatrix<float> product(in->rows(), out->cols());
+		size_t nnz = 0;
+		for(const vector<pair<uint32_t, float>>& d : data) nnz += d.size();
+		product.resizeNonZeros(nnz);
+		int* outer = product.outerIndexPtr();
+		int* inner = product.innerIndexPtr();
+		float* value = product.valuePtr();
+		uint32_t j = 0;
+		size_t p = 0;
+		outer[0] = 0;
+		for(uint32_t iThread = 0; iThread < nThr ; iThread++) {
+			for(uint32_t n : col_nnz[iThread]) {
+				outer[j + 1] = outer[j] + n;
+				++j;
 			}
-			out->setZero();
-			out->setFromTriplets(data.begin(), data.end(), [] (const float&, const float &b) { return b; });
-			*out = out->pruned(1.0, numeric_limits<float>::epsilon());
-			//(*out) = (*out)*(*in);
+			for(const pair<uint32_t, float>& e : data[iThread]) {
+				inner[p] = e.first;
+				value[p++] = e.second;
+			}
+			vector<pair<uint32_t, float>>().swap(data[iThread]);
 		}
+		out->swap(product);
 	}
-	else{ 
-		throw runtime_error(" Eigen does not provide an eigenvalue solver for sparse matrices");
+	if( r < 2 ){
+		get_gamma(out, out, inflation, nThr);
 	}
-	*out = out->pruned();
 	sparse_exp_time += chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - t).count();
 }
 
@@ -219,12 +307,11 @@ void MCL::get_gamma(Eigen::MatrixXf* in, Eigen::MatrixXf* out, float r){
 void MCL::markov_process(Eigen::SparseMatrix<float>* m, float inflation, float expansion, uint32_t max_iter, function<uint32_t()> getThreads){
 	uint32_t iteration = 0;
 	float diff_norm = numeric_limits<float>::max();
-	Eigen::SparseMatrix<float> msquared(m->rows(), m->cols());
 	Eigen::SparseMatrix<float> m_update(m->rows(), m->cols());
 	get_gamma(m, m, 1, getThreads()); // This is to get a matrix of random walks on the graph -> TODO: find out if something else is more suitable
 	while( iteration < max_iter && diff_norm > numeric_limits<float>::epsilon()){
-		get_exp(m, &msquared, expansion, getThreads());
-		get_gamma(&msquared, &m_update, inflation, getThreads());
+		// expansion, pruning and inflation in one pass over the columns
+		get_exp(m, &m_update, expansion, inflation, getThreads());
 		*m -= m_update;
 		diff_norm = sparse_matrix_get_norm(m, getThreads());
 		*m = m_update;
@@ -17,18 +17,90 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #include <unordered_map>
+#include <atomic>
+#include <thread>
 #include "multi_step_cluster.h"
 #include "../util/util.h"
 #include "../util/sequence/sequence.h"
+#include "../util/io/text_input_file.h"
+#include "../util/io/output_file.h"
+#include "../data/dmnd/dmnd.h"
 
 using namespace std;
 
 namespace Workflow { namespace Cluster {
+
+const char* const MultiStep::KMER_STEP = "kmer";
 	
 string MultiStep::get_description() {
 	return "A greedy stepwise vortex cover algorithm";
 }
 
+template<typename F>
+static void run_threads(size_t items, size_t threads, F f) {
+	const Partition<size_t> p(items, std::max(threads, (size_t)1));
+	vector<thread> t;
+	for (size_t i = 0; i < p.parts; ++i)
+		t.emplace_back(f, p.begin(i), p.end(i));
+	for (auto& i : t)
+		i.join();
+}
+
+// edge records per chunk read back from the spilled edges
+static const size_t EDGE_CHUNK = size_t(1) << 24;
+
+void Neighbors::build_graph(size_t threads) {
+	const size_t n = number_edges.size();
+	vector<size_t> limits(n + 1);
+	limits[0] = 0;
+	for (size_t i = 0; i < n; ++i)
+		limits[i + 1] = limits[i] + degree_[i];
+	vector<uint32_t>().swap(degree_);
+
+	vector<atomic<uint32_t>> degree(n);
+	for (size_t i = 0; i < n; ++i)
+		degree[i].store(0, memory_order_relaxed);
+	vector<int> data(limits[n]);
+	if (edge_file_) {
+		InputFile in(*edge_file_);
+		vector<uint32_t> edges(std::min(2 * EDGE_CHUNK, limits[n]));
+		size_t edge_count;
+		while ((edge_count = in.read(edges.data(), edges.size()) / 2) > 0)
+			run_threads(edge_count, threads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const uint32_t query = edges[2 * i], subject = edges[2 * i + 1];
+					dSet.merge(query, subject);
+					data[limits[query] + degree[query].fetch_add(1, memory_order_relaxed)] = (int)subject;
+					data[limits[subject] + degree[subject].fetch_add(1, memory_order_relaxed)] = (int)query;
+				}
+			});
+		in.close_and_delete();
+		edge_file_.reset();
+	}
+
+	// edges are usually reported in both directions, so the lists are sorted and deduplicated
+	run_threads(n, threads, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const auto b = data.begin() + limits[i], e = data.begin() + limits[i + 1];
+			sort(b, e);
+			degree[i].store((uint32_t)(unique(b, e) - b), memory_order_relaxed);
+		}
+	});
+
+	size_t k = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const size_t begin = limits[i], count = degree[i].load(memory_order_relaxed);
+		limits[i] = k;
+		if (k != begin)
+			std::copy(data.begin() + begin, data.begin() + begin + count, data.begin() + k);
+		k += count;
+	}
+	limits[n] = k;
+	// not shrunk, which would hold both copies at once
+	data.resize(k);
+	adjacency = FlatArray<int>(move(data), move(limits));
+}
+
 BitVector MultiStep::rep_bitset(const vector<int> &centroid, const BitVector *superset) {
 	BitVector r(centroid.size());
 	for (int c : centroid)
@@ -37,7 +109,7 @@ BitVector MultiStep::rep_bitset(const vector<int> &centroid, const BitVector *su
 	return r;
 }
 
-vector<int> MultiStep::cluster(shared_ptr<SequenceFile>& db, const shared_ptr<BitVector>& filter) {
+void MultiStep::set_search_options() {
 	statistics.reset();
 	config.command = Config::blastp;
 	//config.no_self_hits = true;
@@ -49,10 +121,16 @@ vector<int> MultiStep::cluster(shared_ptr<SequenceFile>& db, const shared_ptr<Bi
 	config.algo = Config::Algo::DOUBLE_INDEXED;
 	//config.freq_sd = 0;
 	config.max_alignments = numeric_limits<size_t>::max();
+}
+
+vector<int> MultiStep::cluster(shared_ptr<SequenceFile>& db, const shared_ptr<BitVector>& filter) {
+	set_search_options();
 
 	shared_ptr<Neighbors> nb(new Neighbors(db->sequence_count()));
 
 	Search::run(db, nullptr, nb, filter);
+	if (!config.external)
+		nb->build_graph(config.threads_);
 	
 	/*
 	auto lo = nb.dSet.getListOfSets();
@@ -86,7 +164,7 @@ vector<int> MultiStep::cluster(shared_ptr<SequenceFile>& db, const shared_ptr<Bi
 	}
 
 	else {
-		return Util::Algo::greedy_vertex_cover(*nb);
+		return Util::Algo::greedy_vertex_cover(nb->adjacency, config.threads_, config.cluster_cover_rounds);
 	}
 
 }
@@ -139,7 +217,7 @@ vector<int> MultiStep::cluster_sets(const size_t nb_size, vector<TempFile*> &sor
 				break;
 			}
 		}
-		curr = Util::Algo::greedy_vertex_cover(tmp_neighbors);
+		curr = Util::Algo::greedy_vertex_cover(tmp_neighbors, config.threads_, config.cluster_cover_rounds);
 
 		for (int i = 0; i < (int)curr.size(); i++) {
 				if (curr[i] != i) {
@@ -202,53 +280,144 @@ vector<TempFile*> MultiStep::mapping_comp_set(unordered_map<uint32_t, NodEdgSet>
 
 void MultiStep::steps(BitVector& current_reps, BitVector& previous_reps, vector <int>& current_centroids, vector <int>& previous_centroids, int count) {
 
-	if (count == 0) {
-		current_reps = rep_bitset(current_centroids);
-	}
-	else {
-		current_reps = rep_bitset(current_centroids, &previous_reps);
-
+	current_reps = rep_bitset(current_centroids, &previous_reps);
+	if (count > 0)
 		for (size_t i = 0; i < current_centroids.size(); ++i)
 			if (!previous_reps.get(i))
 				current_centroids[i] = current_centroids[previous_centroids[i]];
-	}
 
 	size_t n_rep_1 = previous_reps.one_count();
 	size_t n_rep_2 = current_reps.one_count();
 
-	if (n_rep_1 == 0) {
-		n_rep_1 = current_centroids.size();
-	}
-
 	message_stream << "Clustering step " << count + 1 << " complete. #Input sequences: " << n_rep_1 << " #Clusters: " << n_rep_2 << endl;
 
 	previous_centroids = move(current_centroids);
 	previous_reps = move(current_reps);
 }
 		
+BitVector MultiStep::run_steps(shared_ptr<SequenceFile>& db, const shared_ptr<BitVector>& filter, vector<int>& centroids) {
+	const size_t n = db->sequence_count();
+	shared_ptr<BitVector> current_reps(new BitVector), previous_reps(new BitVector(n));
+	if (filter)
+		*previous_reps = *filter;
+	else
+		previous_reps->negate(n);
+
+	vector<int> current_centroids;
+	for (size_t i = 0; i < config.cluster_steps.size(); i++) {
+		if (config.cluster_steps[i] == KMER_STEP)
+			current_centroids = kmer_cluster(db, i == 0 ? filter : previous_reps);
+		else {
+			config.sensitivity = from_string<Sensitivity>(config.cluster_steps[i]);
+			current_centroids = cluster(db, i == 0 ? filter : previous_reps);
+		}
+		steps(*current_reps, *previous_reps, current_centroids, centroids, i);
+	}
+	return move(*previous_reps);
+}
+
+// Searches the new sequences against the representatives of a previous clustering and assigns them to the
+// representative of their best hit. The remaining new sequences are clustered among themselves and their centroids
+// become new representatives. Only the new rows are computed, the previous membership table is copied unchanged.
+void MultiStep::run_incremental() {
+	if (config.query_file.empty())
+		throw runtime_error("Missing parameter: file of new sequences (--query/-q)");
+	config.command = Config::makedb;
+	shared_ptr<list<TextInputFile>> query_file(new list<TextInputFile>);
+	for (const string& f : config.query_file)
+		query_file->emplace_back(f);
+	TempFile* new_db_file;
+	DatabaseFile::make_db(&new_db_file, query_file.get());
+	shared_ptr<SequenceFile> new_db(new DatabaseFile(*new_db_file));
+	delete new_db_file;
+	const size_t n = new_db->sequence_count();
+
+	shared_ptr<SequenceFile> rep_db(SequenceFile::auto_create());
+	shared_ptr<RepAssignment> assignment(new RepAssignment);
+	for (TextInputFile& f : *query_file)
+		f.rewind();
+	set_search_options();
+	const auto step = find_if(config.cluster_steps.rbegin(), config.cluster_steps.rend(), [](const string& s) { return s != KMER_STEP; });
+	config.sensitivity = step == config.cluster_steps.rend() ? Sensitivity::DEFAULT : from_string<Sensitivity>(*step);
+	config.output_format = { "6", "qseqid", "sseqid" };
+	config.max_alignments = 1;
+	Search::run(rep_db, query_file, assignment);
+	rep_db->close();
+	for (TextInputFile& f : *query_file)
+		f.close();
+
+	task_timer timer("Assigning new sequences to representatives");
+	vector<string> ids;
+	ids.reserve(n);
+	vector<Letter> seq;
+	string id;
+	shared_ptr<BitVector> unassigned(new BitVector(n));
+	new_db->init_seq_access();
+	for (size_t i = 0; i < n; ++i) {
+		new_db->read_seq(seq, id);
+		ids.push_back(Util::Seq::seqid(id.c_str(), false));
+		if (assignment->rep.find(ids.back()) == assignment->rep.end())
+			unassigned->set(i);
+	}
+	const size_t unassigned_count = unassigned->one_count();
+	message_stream << "New sequences: " << n << " #Assigned to existing representatives: " << n - unassigned_count << endl;
+	timer.finish();
+
+	vector<int> centroids(n);
+	BitVector new_reps;
+	if (unassigned_count > 0)
+		new_reps = run_steps(new_db, unassigned, centroids);
+	else
+		new_reps = BitVector(n);
+	message_stream << "New representatives: " << new_reps.one_count() << endl;
+
+	timer.go("Generating output");
+	ostream* out = config.output_file.empty() ? &cout : new ofstream(config.output_file.c_str());
+	TextInputFile previous(config.cluster_previous);
+	while (previous.getline(), !previous.line.empty() || !previous.eof())
+		(*out) << previous.line << '\n';
+	previous.close();
+	for (size_t i = 0; i < n; ++i) {
+		const auto r = assignment->rep.find(ids[i]);
+		(*out) << ids[i] << '\t' << (r != assignment->rep.end() ? r->second : ids[centroids[i]]) << '\n';
+	}
+	if (out != &cout) delete out;
+
+	if (!config.cluster_new_reps.empty()) {
+		OutputFile reps_out(config.cluster_new_reps);
+		TextBuffer buf;
+		new_db->init_seq_access();
+		for (size_t i = 0; i < n; ++i) {
+			new_db->read_seq(seq, id);
+			if (!new_reps.get(i))
+				continue;
+			buf << '>' << id << '\n' << Sequence(seq) << '\n';
+			reps_out.write(buf.data(), buf.size());
+			buf.clear();
+		}
+		reps_out.close();
+	}
+	new_db->close();
+}
+
 void MultiStep::run() {
 	if (config.database == "")
 		throw runtime_error("Missing parameter: database file (--db/-d)");
+	if (!config.cluster_previous.empty()) {
+		run_incremental();
+		return;
+	}
 	config.command = Config::makedb;
 	shared_ptr<SequenceFile> db(SequenceFile::auto_create());
 	const size_t seq_count = db->sequence_count();
 
-	shared_ptr<BitVector> current_reps, previous_reps;
-
-	vector<int> current_centroids;
 	vector<int> previous_centroids;
-	
-	for (size_t i = 0; i < config.cluster_steps.size(); i++) {
-		
-		config.sensitivity = from_string<Sensitivity>(config.cluster_steps[i]);
-		current_centroids = cluster(db, i == 0 ? nullptr : previous_reps);
-		steps(*current_reps, *previous_reps, current_centroids, previous_centroids, i);
-	}
+	const BitVector reps = run_steps(db, nullptr, previous_centroids);
 		
 	task_timer timer("Generating output");
 	vector<unsigned> rep_block_id(seq_count);
 	db->set_seqinfo_ptr(0);
-	Block* block = db->load_seqs((size_t)1e11, true, previous_reps.get());
+	Block* block = db->load_seqs((size_t)1e11, true, &reps);
 	for (size_t i = 0; i < block->seqs().size(); ++i)
 		rep_block_id[block->block_id2oid(i)] = (unsigned)i;
 
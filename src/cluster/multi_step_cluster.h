@@ -38,6 +38,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <numeric>
 #include "../util/io/temp_file.h"
 #include "disjoint_set.h"
+#include "../util/data_structures/flat_array.h"
 
 namespace Workflow { namespace Cluster{ 
 
@@ -50,14 +51,21 @@ namespace Workflow { namespace Cluster{
 class MultiStep : public ClusteringAlgorithm {
 private:
 	BitVector rep_bitset(const vector<int> &centroid, const BitVector *superset = nullptr);
+	static void set_search_options();
 	vector<int> cluster(std::shared_ptr<SequenceFile>& db, const std::shared_ptr<BitVector>& filter);
+	vector<int> kmer_cluster(std::shared_ptr<SequenceFile>& db, const std::shared_ptr<BitVector>& filter);
 	void save_edges_external(vector<TempFile*> &all_edges,vector<TempFile*> &sorted_edges, const unordered_map <uint32_t, NodEdgSet>& comp, const vector<uint32_t>& s_index);
 	vector<int> cluster_sets(const size_t nb_size, vector<TempFile*> &sorted_edges);
 	unordered_map<uint32_t, NodEdgSet> find_connected_components(const vector<unordered_set<uint32_t>> &connected, vector<uint32_t>& EdgSet, const vector<size_t>& nedges);
 	vector<TempFile*> mapping_comp_set(unordered_map<uint32_t, NodEdgSet>& comp);
 	void steps(BitVector& current_reps, BitVector& previous_reps, vector<int>& current_centroids, vector<int>& previous_centroids, int count);
+	// runs all clustering steps on the sequences in filter (all if null) and returns the final representatives
+	BitVector run_steps(std::shared_ptr<SequenceFile>& db, const std::shared_ptr<BitVector>& filter, vector<int>& centroids);
+	void run_incremental();
 
 public:
+	// name of the k-mer preclustering step in --cluster-steps
+	static const char* const KMER_STEP;
 	~MultiStep(){};
 	void run();
 	string get_description();
@@ -66,46 +74,79 @@ public:
 	}
 };
 
-struct Neighbors : public vector<vector<int>>, public Consumer {
-	Neighbors(size_t n) : vector<vector<int>>(n), smallest_index(n,0), number_edges(n,0), dSet(n){
-		iota(smallest_index.begin(), smallest_index.end(), 0);
+// Collects the first reported target of each query from tabular output with the fields qseqid and sseqid.
+struct RepAssignment : public Consumer {
+
+	unordered_map<string, string> rep;
+
+	virtual void consume(const char* ptr, size_t n) override {
+		line_.append(ptr, n);
+		size_t begin = 0, end;
+		while ((end = line_.find('\n', begin)) != string::npos) {
+			const size_t tab = line_.find('\t', begin);
+			if (tab < end)
+				rep.emplace(line_.substr(begin, tab - begin), line_.substr(tab + 1, end - tab - 1));
+			begin = end + 1;
+		}
+		line_.erase(0, begin);
 	}
 
-	vector<uint32_t> smallest_index;
+private:
+
+	string line_;
+
+};
+
+struct Neighbors : public Consumer {
+	Neighbors(size_t n) : number_edges(n,0), size(0), dSet(n), degree_(n, 0){}
+
 	vector<size_t> number_edges;
 	vector<TempFile*> tempfiles;
-	size_t size;	
-	LazyDisjointIntegralSet<uint32_t> dSet;
+	size_t size;
+	ConcurrentDisjointSet<uint32_t> dSet;
+	// symmetric adjacency lists, available after build_graph
+	FlatArray<int> adjacency;
 
+	// Merges the disjoint sets and builds the adjacency lists from the spilled edges, using the given number of threads.
+	void build_graph(size_t threads);
 
 	virtual void consume(const char* ptr, size_t n) override {
-		const char* end = ptr + n;
-
 		if (config.external) {
+			const char* end = ptr + n;
 			size += n;
 			if (tempfiles.empty() || size >= UINT32_MAX) {
 				tempfiles.push_back(new TempFile());
 				size = 0;
 			}
 			tempfiles.back()->write(ptr, n);
-		}
-
-		while (ptr < end) {
-			const uint32_t query = *(uint32_t*)ptr;
-			ptr += sizeof(uint32_t);
-			const uint32_t subject = *(uint32_t*)ptr;
-			ptr += sizeof(uint32_t);
 
-			if (!config.external) {
-				(*this)[query].push_back(subject);
+			while (ptr < end) {
+				const uint32_t query = *(uint32_t*)ptr;
+				ptr += sizeof(uint32_t);
+				const uint32_t subject = *(uint32_t*)ptr;
+				ptr += sizeof(uint32_t);
+				dSet.merge(query, subject);
+				++number_edges[query];
+			}
+		}
+		else {
+			// the (query, subject) records are spilled, so that only the adjacency arrays sized from these degrees are
+			// held in memory when the graph is built
+			if (!edge_file_)
+				edge_file_.reset(new TempFile());
+			edge_file_->write(ptr, n);
+			for (const uint32_t* p = (const uint32_t*)ptr, *end = (const uint32_t*)(ptr + n); p < end; p += 2) {
+				++number_edges[p[0]];
+				++degree_[p[0]];
+				++degree_[p[1]];
 			}
-
-			dSet.merge(query, subject);
-		
-			++number_edges[query];
-
 		}
 	}
 
+private:
+
+	vector<uint32_t> degree_;
+	std::unique_ptr<TempFile> edge_file_;
+
 };
 }}
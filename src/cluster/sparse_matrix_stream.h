@@ -26,9 +26,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
 #include "disjoint_set.h"
 #include "../util/io/consumer.h"
 #include "cluster.h"
+#include "../basic/config.h"
+#define _REENTRANT
+#include "../lib/ips4o/ips4o.hpp"
 
 	using namespace std;
 
@@ -43,18 +48,24 @@ class SparseMatrixStream : public Consumer {
 	bool in_memory, is_tmp_file, warned;
 	float max_size;
 	char* buffer;
-	static bool cmp(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) { 
-		return lhs.row() == rhs.row() ? lhs.col() < rhs.col() : lhs.row() < rhs.row() ; 
-	};
-	static bool symmcmp(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) { 
-		auto maxL = max(lhs.row(), lhs.col());
-		auto minL = min(lhs.row(), lhs.col());
-		auto maxR = max(rhs.row(), rhs.col());
-		auto minR = min(rhs.row(), rhs.col());
-		return maxL == maxR ? minL < minR : maxL < maxR ; 
+	// Edges are identified by (row, col), or by the unordered pair if the matrix is symmetric
+	static uint64_t key(const Eigen::Triplet<T>& t, bool symmetric) {
+		const uint64_t row = (uint32_t)t.row(), col = (uint32_t)t.col();
+		return symmetric ? (max(row, col) << 32) | min(row, col) : (row << 32) | col;
+	}
+	struct EdgeCmp {
+		// duplicates of an edge sort by descending value so that the first one is kept
+		bool operator()(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) const {
+			const uint64_t kl = key(lhs, symmetric), kr = key(rhs, symmetric);
+			return kl < kr || (kl == kr && lhs.value() > rhs.value());
+		}
+		bool symmetric;
 	};
-	set<Eigen::Triplet<T>, bool(*)(const Eigen::Triplet<T>& lhs,const Eigen::Triplet<T>& rhs)>* data;
-	//set<Eigen::Triplet<T>, decltype(cmp)> data;
+	// Append-only edge buffer, data[0, sorted_size) is sorted and free of duplicates
+	vector<Eigen::Triplet<T>> data;
+	size_t sorted_size;
+	uint64_t n_dumped;
+	size_t sort_threads;
 	LazyDisjointSet<uint32_t>* disjointSet;
 	string file_name;
 	ofstream* os;
@@ -67,9 +78,36 @@ class SparseMatrixStream : public Consumer {
 		}
 	}
 
-	vector<vector<Eigen::Triplet<T>>> split_data(map<uint32_t, uint32_t>& indexToSetId, size_t size){
+	bool over_budget() const {
+		return (data.size()*unit_size*1.0)/(1024ULL*1024*1024) > max_size;
+	}
+
+	// Sorts the unsorted tail of the buffer, merges it into the sorted part and drops duplicate edges, keeping the maximum value
+	void compact(){
+		if(sorted_size == data.size())
+			return;
+		const EdgeCmp cmp{ symmetric };
+		if(sort_threads > 1)
+			ips4o::parallel::sort(data.begin() + sorted_size, data.end(), cmp, sort_threads);
+		else
+			ips4o::sort(data.begin() + sorted_size, data.end(), cmp);
+		inplace_merge(data.begin(), data.begin() + sorted_size, data.end(), cmp);
+		const bool symm = symmetric;
+		data.erase(unique(data.begin(), data.end(), [symm](const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs){
+			return key(lhs, symm) == key(rhs, symm);
+		}), data.end());
+		sorted_size = data.size();
+	}
+
+	void clear_data(){
+		data.clear();
+		sorted_size = 0;
+	}
+
+	vector<vector<Eigen::Triplet<T>>> split_data(unordered_map<uint32_t, uint32_t>& indexToSetId, size_t size){
+		compact();
 		vector<vector<Eigen::Triplet<T>>> split(size);
-		for(Eigen::Triplet<T> t : *data){
+		for(const Eigen::Triplet<T>& t : data){
 			uint32_t iset = indexToSetId[t.row()];
 			assert( iset == indexToSetId[t.col()]);
 			split[iset].emplace_back(t.row(), t.col(), t.value());
@@ -78,16 +116,17 @@ class SparseMatrixStream : public Consumer {
 	}
 
 	void dump(){
-		if(os && data->size() > 0){
+		if(os && data.size() > 0){
 			this->in_memory = false;
 			vector<vector<uint32_t>> indices = get_indices();
-			map<uint32_t, uint32_t> indexToSetId;
+			unordered_map<uint32_t, uint32_t> indexToSetId;
 			for(uint32_t iset = 0; iset < indices.size(); iset++){
 				for(uint32_t index : indices.at(iset)){
 					indexToSetId.emplace(index, iset);
 				}
 			}
 			vector<vector<Eigen::Triplet<T>>> components = split_data(indexToSetId, indices.size());
+			n_dumped += data.size();
 			for(uint32_t iComponent = 0; iComponent < components.size(); iComponent++){
 				const uint32_t size = components[iComponent].size();
 				if( size > 0 ){
@@ -122,18 +161,15 @@ class SparseMatrixStream : public Consumer {
 					warned=true;
 				}
 				ptr += sizeof(double);
-				Eigen::Triplet<T> t(query, subject, value);
-				auto it = data->find(t);
-				if(it == data->end()){
-					data->emplace(move(t));
-					disjointSet->merge(query, subject);
-				}
-				else if (t.value() > it->value()){
-					data->emplace_hint(data->erase(it), move(t));
-				}
-				if(os && (data->size()*unit_size*1.0)/(1024ULL*1024*1024) > max_size){
-					dump();
-					data->clear();
+				data.emplace_back(query, subject, value);
+				disjointSet->merge(query, subject);
+				if(os && over_budget()){
+					// only spill to disk if removing the duplicates does not free enough of the buffer
+					compact();
+					if((data.size()*unit_size*2.0)/(1024ULL*1024*1024) > max_size){
+						dump();
+						clear_data();
+					}
 				}
 			}
 		}
@@ -161,7 +197,7 @@ class SparseMatrixStream : public Consumer {
 		return os;
 	}
 
-	vector<Eigen::Triplet<T>> remap(vector<Eigen::Triplet<T>>& split, map<uint32_t, uint32_t>& index_map){
+	vector<Eigen::Triplet<T>> remap(vector<Eigen::Triplet<T>>& split, unordered_map<uint32_t, uint32_t>& index_map){
 		vector<Eigen::Triplet<T>> remapped;
 		for(Eigen::Triplet<T> const & t : split){
 			remapped.emplace_back(index_map[t.row()], index_map[t.col()], t.value());
@@ -173,7 +209,7 @@ class SparseMatrixStream : public Consumer {
 	vector<vector<Eigen::Triplet<T>>> getComponents(vector<vector<uint32_t>*>* indices){
 		vector<vector<Eigen::Triplet<T>>> split;
 		{
-			map<uint32_t, uint32_t> indexToSetId;
+			unordered_map<uint32_t, uint32_t> indexToSetId;
 			for(uint32_t iset = 0; iset < indices->size(); iset++){
 				for(uint32_t index : *(indices->at(iset))){
 					indexToSetId.emplace(index, iset);
@@ -184,7 +220,7 @@ class SparseMatrixStream : public Consumer {
 		vector<vector<Eigen::Triplet<T>>> components;
 		for(uint32_t iset = 0; iset < indices->size(); iset++){
 			if(split[iset].size() > 0){
-				map<uint32_t, uint32_t> index_map;
+				unordered_map<uint32_t, uint32_t> index_map;
 				uint32_t iel = 0;
 				for(uint32_t const & el: *(indices->at(iset))){
 					index_map.emplace(el, iel++);
@@ -195,23 +231,18 @@ class SparseMatrixStream : public Consumer {
 		return components;
 	}
 
-	SparseMatrixStream(const bool symmetric, size_t n): n(n), nThreads(0), symmetric(symmetric), in_memory(false), is_tmp_file(false), warned(false), max_size(2.0), buffer(nullptr), os(nullptr){
-		bool(*function_pointer)(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) = symmetric ? symmcmp : cmp;
-		data = new std::set<Eigen::Triplet<T>, bool(*)(const Eigen::Triplet<T>& lhs,const Eigen::Triplet<T>& rhs)>(function_pointer);
+	SparseMatrixStream(const bool symmetric, size_t n): n(n), nThreads(0), symmetric(symmetric), in_memory(false), is_tmp_file(false), warned(false), max_size(2.0), buffer(nullptr), sorted_size(0), n_dumped(0), sort_threads(config.threads_), os(nullptr){
 		disjointSet = new LazyDisjointIntegralSet<uint32_t>(n); 
 	}
 
-	SparseMatrixStream(const bool symmetric, unordered_set<uint32_t>* set) :  nThreads(0), symmetric(symmetric), in_memory(true), is_tmp_file(false), warned(true), max_size(2.0), buffer(nullptr), os(nullptr){
-		bool(*function_pointer)(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) = symmetric ? symmcmp : cmp;
-		data = new std::set<Eigen::Triplet<T>, bool(*)(const Eigen::Triplet<T>& lhs,const Eigen::Triplet<T>& rhs)>(function_pointer);
+	// used from the clustering threads, so the buffer is sorted single-threaded
+	SparseMatrixStream(const bool symmetric, unordered_set<uint32_t>* set) :  nThreads(0), symmetric(symmetric), in_memory(true), is_tmp_file(false), warned(true), max_size(2.0), buffer(nullptr), sorted_size(0), n_dumped(0), sort_threads(1), os(nullptr){
 		this->n = set->size();
 		disjointSet = new LazyDisjointTypeSet<uint32_t>(set); 
 	}
 
 public:
-	SparseMatrixStream(const bool symmetric, size_t n, string graph_file_name) : n(n), nThreads(0), symmetric(symmetric), in_memory(false), warned(false), max_size(2.0), buffer(nullptr) {
-		bool(*function_pointer)(const Eigen::Triplet<T>& lhs, const Eigen::Triplet<T>& rhs) = symmetric ? symmcmp : cmp;
-		data = new std::set<Eigen::Triplet<T>, bool(*)(const Eigen::Triplet<T>& lhs,const Eigen::Triplet<T>& rhs)>(function_pointer);
+	SparseMatrixStream(const bool symmetric, size_t n, string graph_file_name) : n(n), nThreads(0), symmetric(symmetric), in_memory(false), warned(false), max_size(2.0), buffer(nullptr), sorted_size(0), n_dumped(0), sort_threads(config.threads_) {
 		disjointSet = new LazyDisjointIntegralSet<uint32_t>(n); 
 		if(graph_file_name.empty()){
 			this->is_tmp_file = true;
@@ -238,9 +269,11 @@ public:
 	void done(){
 		if(!in_memory){
 			dump();
-			data->clear();
-			delete data;
+			clear_data();
+			data.shrink_to_fit();
 		}
+		else
+			compact();
 		if(os){
 			os->close();
 			delete os;
@@ -297,7 +330,7 @@ public:
 			for(uint32_t ichunk = 0; ichunk < ceil(block_size/(1.0 * read_buffer_size)); ichunk++){
 				const unsigned long long bytes = min(read_buffer_size - (read_buffer_size % unit_size), block_size - bytes_read);
 				in.read(local_buffer, bytes);
-				if((sms->data->size()*unit_size*1.0)/(1024ULL*1024*1024) < sms->max_size){
+				if(!sms->over_budget()){
 					sms->consume(local_buffer, bytes);
 				}
 				else{
@@ -307,8 +340,9 @@ public:
 			}
 		}
 		in.close();
-		if((sms->data->size()*unit_size*1.0)/(1024ULL*1024*1024) >= sms->max_size){
-			sms->data->clear();
+		sms->compact();
+		if(sms->over_budget()){
+			sms->clear_data();
 			sms->in_memory = false;
 		}
 		delete[] local_buffer;
@@ -376,7 +410,7 @@ public:
 		return indices;
 	}
 	uint64_t getNumberOfElements(){
-		return data->size();
+		return n_dumped + data.size();
 	}
 };
 }}
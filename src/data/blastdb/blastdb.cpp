@@ -110,6 +110,11 @@ void BlastDB::init_seq_access()
 {
 }
 
+void BlastDB::seek_seq(size_t oid)
+{
+	oid_ = (int)oid;
+}
+
 void BlastDB::seek_chunk(const Chunk& chunk)
 {
 }
@@ -309,6 +314,11 @@ void BlastDB::reopen()
 		db_.reset(new CSeqDBExpert(file_name_, CSeqDB::eProtein));
 }
 
+SeedFrequencyTable* BlastDB::seed_freq_table()
+{
+	return nullptr;
+}
+
 BitVector* BlastDB::filter_by_accession(const std::string& file_name)
 {
 	BitVector* v = new BitVector(sequence_count());
@@ -10,6 +10,7 @@ struct BlastDB : public SequenceFile {
 
 	virtual void init_seqinfo_access() override;
 	virtual void init_seq_access() override;
+	virtual void seek_seq(size_t oid) override;
 	virtual void seek_chunk(const Chunk& chunk) override;
 	virtual size_t tell_seq() const override;
 	virtual SeqInfo read_seqinfo() override;
@@ -41,6 +42,7 @@ struct BlastDB : public SequenceFile {
 	virtual void close_weakly() override;
 	virtual void reopen() override;
 	virtual BitVector* filter_by_accession(const std::string& file_name) override;
+	virtual SeedFrequencyTable* seed_freq_table() override;
 	virtual BitVector* filter_by_taxonomy(const std::string& include, const std::string& exclude, TaxonomyNodes& nodes) override;
 	virtual const BitVector* builtin_filter() override;
 	virtual std::string file_name() override;
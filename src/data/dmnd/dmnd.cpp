@@ -38,6 +38,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../taxonomy.h"
 #include "../util/system/system.h"
 #include "../util/algo/external_sort.h"
+#include "../frequent_seeds.h"
+#include "../../search/search.h"
+#include "../util/sequence/sequence.h"
 #include "../../util/util.h"
 
 using std::tuple;
@@ -53,7 +56,7 @@ Serializer& operator<<(Serializer &s, const ReferenceHeader2 &h)
 	s.unset(Serializer::VARINT);
 	s << sizeof(ReferenceHeader2);
 	s.write(h.hash, sizeof(h.hash));
-	s << h.taxon_array_offset << h.taxon_array_size << h.taxon_nodes_offset << h.taxon_names_offset;
+	s << h.taxon_array_offset << h.taxon_array_size << h.taxon_nodes_offset << h.taxon_names_offset << h.taxon_index_offset << h.accession_index_offset << h.seed_freq_offset;
 	return s;
 }
 
@@ -64,6 +67,9 @@ Deserializer& operator>>(Deserializer &d, ReferenceHeader2 &h)
 		>> h.taxon_array_size
 		>> h.taxon_nodes_offset
 		>> h.taxon_names_offset
+		>> h.taxon_index_offset
+		>> h.accession_index_offset
+		>> h.seed_freq_offset
 		>> Finish();
 	return d;
 }
@@ -233,6 +239,18 @@ bool DatabaseFile::has_taxon_scientific_names() const {
 	return header2.taxon_names_offset != 0;
 }
 
+bool DatabaseFile::has_taxon_index() const {
+	return header2.taxon_index_offset != 0;
+}
+
+bool DatabaseFile::has_accession_index() const {
+	return header2.accession_index_offset != 0;
+}
+
+bool DatabaseFile::has_seed_freq_table() const {
+	return header2.seed_freq_offset != 0;
+}
+
 static void push_seq(const Sequence &seq, const char *id, size_t id_len, uint64_t &offset, vector<SeqInfo> &pos_array, OutputFile &out, size_t &letters, size_t &n_seqs)
 {
 	pos_array.emplace_back(offset, seq.length());
@@ -245,6 +263,37 @@ static void push_seq(const Sequence &seq, const char *id, size_t id_len, uint64_
 	offset += seq.length() + id_len + 3;
 }
 
+// Sorted (accession, oid) records, with the first accession and file offset of every block of records kept in a
+// table so that lookups only need to read a single block.
+static const uint64_t ACCESSION_INDEX_BLOCK = 256;
+
+static uint64_t build_accession_index(OutputFile& db, ExternalSorter<pair<string, uint32_t>>& acc2oid)
+{
+	task_timer timer("Writing accession index");
+	db.unset(Serializer::VARINT);
+	acc2oid.init_read();
+	vector<string> keys;
+	vector<uint64_t> offsets;
+	uint64_t n = 0;
+	while (acc2oid.good()) {
+		const pair<string, uint32_t>& p = *acc2oid;
+		if (n % ACCESSION_INDEX_BLOCK == 0) {
+			keys.push_back(p.first);
+			offsets.push_back(db.tell());
+		}
+		db << p.first << p.second;
+		++n;
+		++acc2oid;
+	}
+	offsets.push_back(db.tell());
+
+	const uint64_t table_offset = db.tell();
+	db << n << keys << (uint64_t)offsets.size();
+	for (uint64_t i : offsets)
+		db << i;
+	return table_offset;
+}
+
 void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 {
 	config.file_buffer_size = 4 * MEGABYTES;
@@ -279,7 +328,8 @@ void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 	Block* block;
 	const FASTA_format format;
 	vector<SeqInfo> pos_array;
-	ExternalSorter<pair<string, uint32_t>> accessions;
+	ExternalSorter<pair<string, uint32_t>> accessions, acc2oid;
+	ExternalSorter<TaxonList::TaxidOid> taxid2oid;
 
 	try {
 		while (true) {
@@ -301,12 +351,16 @@ void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 					throw std::runtime_error("File format error: sequence of length 0 at line " + std::to_string(db_file->front().line_count));
 				push_seq(seq, block->ids()[i], block->ids().length(i), offset, pos_array, *out, letters, n_seqs);
 			}
-			if (!config.prot_accession2taxid.empty()) {
+			if (!config.prot_accession2taxid.empty() || config.accession_index) {
 				timer.go("Writing accessions");
 				for (size_t i = 0; i < n; ++i) {
 					vector<string> acc = accession_from_title(block->ids()[i]);
-					for (const string& s : acc)
-						accessions.push(std::make_pair(s, total_seqs + i));
+					for (const string& s : acc) {
+						if (!config.prot_accession2taxid.empty())
+							accessions.push(std::make_pair(s, total_seqs + i));
+						if (config.accession_index)
+							acc2oid.push(std::make_pair(s, total_seqs + i));
+					}
 				}
 			}
 			timer.go("Hashing sequences");
@@ -342,9 +396,12 @@ void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 	taxonomy.init();
 	if (!config.prot_accession2taxid.empty()) {
 		header2.taxon_array_offset = out->tell();
-		TaxonList::build(*out, accessions, n_seqs, stats);
+		TaxonList::build(*out, accessions, n_seqs, stats, taxid2oid);
 		header2.taxon_array_size = out->tell() - header2.taxon_array_offset;
+		header2.taxon_index_offset = TaxonList::build_index(*out, taxid2oid);
 	}
+	if (config.accession_index)
+		header2.accession_index_offset = build_accession_index(*out, acc2oid);
 	if (!config.nodesdmp.empty()) {
 		header2.taxon_nodes_offset = out->tell();
 		TaxonomyNodes::build(*out);
@@ -363,6 +420,7 @@ void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 	timer.go("Closing the database file");
 	header.letters = letters;
 	header.sequences = n_seqs;
+	const size_t end = out->tell();
 	out->seek(0);
 	*out << header;
 	*out << header2;
@@ -372,8 +430,29 @@ void DatabaseFile::make_db(TempFile **tmp_out, list<TextInputFile> *input_file)
 		out->close();
 		delete out;
 	}
-
 	timer.finish();
+
+	// the table is computed from the sequences as stored, so it is appended to the finished file
+	if (config.freq_table && !tmp_out) {
+		::shapes = ShapeConfig(config.shape_mask.empty() ? shape_codes.at(config.sensitivity) : config.shape_mask, config.shapes);
+		std::unique_ptr<SeedFrequencyTable> table;
+		{
+			DatabaseFile db(config.database);
+			table.reset(new SeedFrequencyTable(static_cast<SequenceFile&>(db)));
+			db.close();
+		}
+		timer.go("Writing seed frequency table");
+		OutputFile f(config.database, Compressor::NONE, "r+b");
+		f.seek(end);
+		f << *table;
+		header2.seed_freq_offset = end;
+		f.seek(0);
+		f << header;
+		f << header2;
+		f.close();
+		timer.finish();
+	}
+
 	stats("Database hash", hex_print(header2.hash, 16));
 	stats("Total time", total.get(), "s");
 
@@ -389,7 +468,18 @@ size_t DatabaseFile::tell_seq() const {
 }
 
 void DatabaseFile::init_seq_access() {
-	seek(sizeof(ReferenceHeader) + sizeof(ReferenceHeader2) + 8);
+	// the size of the second header depends on the database version, so the sequence data is located via the position array
+	seek(ref_header.pos_array_offset);
+	SeqInfo r;
+	(*this) >> r;
+	seek(r.pos);
+}
+
+void DatabaseFile::seek_seq(size_t oid) {
+	seek(ref_header.pos_array_offset + SeqInfo::SIZE * oid);
+	SeqInfo r;
+	(*this) >> r;
+	seek(r.pos);
 }
 
 void DatabaseFile::read_seq(vector<Letter>& seq, string &id)
@@ -608,6 +698,10 @@ SequenceFile::Metadata DatabaseFile::metadata() const {
 	return flags;
 }
 
+SeedFrequencyTable* DatabaseFile::seed_freq_table() {
+	return has_seed_freq_table() ? new SeedFrequencyTable(seek(header2.seed_freq_offset)) : nullptr;
+}
+
 TaxonomyNodes* DatabaseFile::taxon_nodes() {
 	return new TaxonomyNodes(seek(header2.taxon_nodes_offset), ref_header.build);
 }
@@ -630,8 +724,54 @@ void DatabaseFile::reopen()
 
 BitVector* DatabaseFile::filter_by_accession(const std::string& file_name)
 {
-	throw std::runtime_error("The .dmnd database format does not support filtering by accession.");
-	return nullptr;
+	if (!has_accession_index())
+		throw std::runtime_error("Database does not contain an accession index (build it using makedb --accession-index).");
+	vector<pair<string, string>> accs;
+	TextInputFile in(file_name);
+	while (in.getline(), (!in.line.empty() || !in.eof()))
+		if (!in.line.empty())
+			accs.emplace_back(get_accession(Util::Seq::seqid(in.line.c_str(), false)), in.line);
+	in.close();
+	std::sort(accs.begin(), accs.end());
+
+	uint64_t n, offset_count;
+	vector<string> keys;
+	vector<uint64_t> offsets;
+	seek(header2.accession_index_offset);
+	varint = false;
+	*this >> n >> keys >> offset_count;
+	offsets.resize(offset_count);
+	for (uint64_t& i : offsets)
+		*this >> i;
+
+	BitVector* v = new BitVector(sequence_count());
+	string key;
+	uint32_t oid;
+	for (const pair<string, string>& acc : accs) {
+		// an accession can continue from the end of the block preceding the first block that starts with it
+		const size_t b = std::lower_bound(keys.begin(), keys.end(), acc.first) - keys.begin();
+		uint64_t pos = offsets[b == 0 ? 0 : b - 1];
+		bool found = false;
+		seek(pos);
+		while (pos < offsets.back()) {
+			*this >> key >> oid;
+			pos += key.length() + 1 + sizeof(uint32_t);
+			const int c = key.compare(acc.first);
+			if (c > 0)
+				break;
+			if (c == 0) {
+				v->set(oid);
+				found = true;
+			}
+		}
+		if (!found) {
+			if (config.skip_missing_seqids)
+				message_stream << "WARNING: Accession not found in database : " + acc.second << endl;
+			else
+				throw std::runtime_error("Accession not found in database: " + acc.second + ". Use --skip-missing-seqids to ignore.");
+		}
+	}
+	return v;
 }
 
 BitVector* DatabaseFile::filter_by_taxonomy(const std::string& include, const std::string& exclude, TaxonomyNodes& nodes)
@@ -647,6 +787,37 @@ BitVector* DatabaseFile::filter_by_taxonomy(const std::string& include, const st
 		throw std::runtime_error("Option --taxonlist/--taxon-exclude used with empty list.");
 	if (taxon_filter_list.find(1) != taxon_filter_list.end() || taxon_filter_list.find(0) != taxon_filter_list.end())
 		throw std::runtime_error("Option --taxonlist/--taxon-exclude used with invalid argument (0 or 1).");
+	if (has_taxon_index()) {
+		// union of the OID lists of all taxa below the filter taxa, each distinct taxon is resolved only once
+		uint64_t data_offset, n;
+		vector<uint32_t> taxids;
+		vector<uint64_t> limits;
+		seek(header2.taxon_index_offset);
+		varint = false;
+		*this >> data_offset >> taxids >> n;
+		limits.resize(n);
+		for (uint64_t& i : limits)
+			*this >> i;
+		vector<uint32_t> oids;
+		bool positioned = false;
+		for (size_t i = 0; i < taxids.size(); ++i) {
+			if (!nodes.contained(taxids[i], taxon_filter_list)) {
+				positioned = false;
+				continue;
+			}
+			if (!positioned)
+				seek(data_offset + limits[i] * sizeof(uint32_t));
+			oids.resize(limits[i + 1] - limits[i]);
+			if (read(oids.data(), oids.size()) != oids.size())
+				throw std::runtime_error("Error reading taxon index.");
+			for (uint32_t oid : oids)
+				v->set(big_endian_byteswap(oid));
+			positioned = true;
+		}
+		if (e)
+			v->negate(taxon_list_->size());
+		return v;
+	}
 	for (size_t i = 0; i < taxon_list_->size(); ++i)
 		if (nodes.contained((*taxon_list_)[i], taxon_filter_list) ^ e)
 			v->set(i);
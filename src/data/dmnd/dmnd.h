@@ -42,7 +42,8 @@ struct ReferenceHeader
 	uint64_t magic_number;
 	uint32_t build, db_version;
 	uint64_t sequences, letters, pos_array_offset;
-	enum { current_db_version = 3 };
+	// version 4 extends the second header, which older builds expect to have a fixed size
+	enum { current_db_version = 4 };
 	static constexpr uint64_t MAGIC_NUMBER = 0x24af8a415ee186dllu;
 	friend InputFile& operator>>(InputFile& file, ReferenceHeader& h);
 };
@@ -53,12 +54,15 @@ struct ReferenceHeader2
 		taxon_array_offset(0),
 		taxon_array_size(0),
 		taxon_nodes_offset(0),
-		taxon_names_offset(0)
+		taxon_names_offset(0),
+		taxon_index_offset(0),
+		accession_index_offset(0),
+		seed_freq_offset(0)
 	{
 		memset(hash, 0, sizeof(hash));
 	}
 	char hash[16];
-	uint64_t taxon_array_offset, taxon_array_size, taxon_nodes_offset, taxon_names_offset;
+	uint64_t taxon_array_offset, taxon_array_size, taxon_nodes_offset, taxon_names_offset, taxon_index_offset, accession_index_offset, seed_freq_offset;
 
 	friend Serializer& operator<<(Serializer &s, const ReferenceHeader2 &h);
 	friend Deserializer& operator>>(Deserializer &d, ReferenceHeader2 &h);
@@ -90,10 +94,14 @@ struct DatabaseFile : public SequenceFile, public InputFile
 	bool has_taxon_id_lists() const;
 	bool has_taxon_nodes() const;
 	bool has_taxon_scientific_names() const;
+	bool has_taxon_index() const;
+	bool has_accession_index() const;
+	bool has_seed_freq_table() const;
 	virtual void close() override;
 	virtual void set_seqinfo_ptr(size_t i) override;
 	virtual size_t tell_seq() const override;
 	virtual void init_seq_access() override;
+	virtual void seek_seq(size_t oid) override;
 	static void make_db(TempFile** tmp_out = nullptr, std::list<TextInputFile>* input_file = nullptr);
 
 	enum { min_build_required = 74, MIN_DB_VERSION = 2 };
@@ -140,6 +148,7 @@ struct DatabaseFile : public SequenceFile, public InputFile
 	virtual void close_weakly() override;
 	virtual void reopen() override;
 	virtual BitVector* filter_by_accession(const std::string& file_name) override;
+	virtual SeedFrequencyTable* seed_freq_table() override;
 	virtual BitVector* filter_by_taxonomy(const std::string& include, const std::string& exclude, TaxonomyNodes& nodes) override;
 	virtual const BitVector* builtin_filter() override;
 	virtual std::string file_name() override;
@@ -1,13 +1,89 @@
 #pragma once
 
+#include <limits>
+#include <algorithm>
 #include "sequence_set.h"
 
 enum class SeedEncoding { SPACED_FACTOR, HASHED, CONTIGUOUS };
 
+struct SyncmerFilter;
+
+// Filters that need the letters of a seed get an overload taking the reduced letters.
+template<typename _filter>
+inline bool filter_contains(const _filter* filter, uint64_t key, uint64_t shape, const Letter* seed)
+{
+	return filter->contains(key, shape);
+}
+
+inline bool filter_contains(const SyncmerFilter* filter, uint64_t key, uint64_t shape, const Letter* seed);
+
+// Filters that probe a table at a random address set SIZE to the number of seeds that their batched contains() takes.
+template<typename _filter>
+struct FilterBatch
+{
+	static const size_t SIZE = 0;
+};
+
+// Passes the seeds that pass the filter on to the callback, in the order of enumeration. With a batched filter, the
+// seeds are buffered and tested one batch at a time.
+template<typename _f, typename _filter, size_t _n = FilterBatch<_filter>::SIZE>
+struct FilteredSeeds
+{
+	FilteredSeeds(_f* f, const _filter* filter):
+		f_(f),
+		filter_(filter),
+		n_(0)
+	{}
+	void operator()(uint64_t key, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		key_[n_] = key;
+		pos_[n_] = pos;
+		block_id_[n_] = block_id;
+		shape_[n_] = shape;
+		if (++n_ == _n)
+			flush();
+	}
+	void flush()
+	{
+		filter_->contains(key_, shape_, n_, hit_);
+		for (size_t i = 0; i < n_; ++i)
+			if (hit_[i])
+				(*f_)(key_[i], pos_[i], block_id_[i], shape_[i]);
+		n_ = 0;
+	}
+private:
+	_f* f_;
+	const _filter* filter_;
+	size_t n_;
+	uint64_t key_[_n], pos_[_n], shape_[_n];
+	uint32_t block_id_[_n];
+	bool hit_[_n];
+};
+
+template<typename _f, typename _filter>
+struct FilteredSeeds<_f, _filter, 0>
+{
+	FilteredSeeds(_f* f, const _filter* filter):
+		f_(f),
+		filter_(filter)
+	{}
+	void operator()(uint64_t key, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		if (filter_->contains(key, shape))
+			(*f_)(key, pos, block_id, shape);
+	}
+	void flush()
+	{}
+private:
+	_f* f_;
+	const _filter* filter_;
+};
+
 template<typename _f, typename _filter>
 void enum_seeds(SequenceSet* seqs, _f* f, unsigned begin, unsigned end, std::pair<size_t, size_t> shape_range, const _filter* filter, const std::vector<bool>* skip)
 {
 	vector<Letter> buf(seqs->max_len(begin, end));
+	vector<uint32_t> runs;
 	uint64_t key;
 	for (unsigned i = begin; i < end; ++i) {
 		if (skip && (*skip)[i / align_mode.query_contexts])
@@ -15,14 +91,15 @@ void enum_seeds(SequenceSet* seqs, _f* f, unsigned begin, unsigned end, std::pai
 		seqs->convert_to_std_alph(i);
 		const Sequence seq = (*seqs)[i];
 		Reduction::reduce_seq(seq, buf);
+		unmasked_runs(buf, runs);
 		for (size_t shape_id = shape_range.first; shape_id < shape_range.second; ++shape_id) {
 			const Shape& sh = shapes[shape_id];
 			if (seq.length() < sh.length_) continue;
-			Seed_iterator it(buf, sh);
+			Seed_iterator it(buf, runs, sh);
 			size_t j = 0;
 			while (it.good()) {
 				if (it.get(key, sh))
-					if (filter->contains(key, shape_id))
+					if (filter_contains(filter, key, shape_id, buf.data() + j))
 						(*f)(key, seqs->position(i, j), i, shape_id);
 				++j;
 			}
@@ -31,31 +108,90 @@ void enum_seeds(SequenceSet* seqs, _f* f, unsigned begin, unsigned end, std::pai
 	f->finish();
 }
 
+// Extracts the seeds of all shapes from one rolling window of reduced letters per sequence, so that each letter is
+// read and reduced only once. The seeds are the same as those of Hashed_seed_iterator: a letter that is not an amino
+// acid enters the window as 0, except within the first length-1 letters of a sequence, which the iterator of a shape
+// reduces without checking. A second window holds these values for the prefix of the sequence.
 template<typename _f, uint64_t _b, typename _filter>
 void enum_seeds_hashed(SequenceSet* seqs, _f* f, unsigned begin, unsigned end, std::pair<size_t, size_t> shape_range, const _filter* filter, const std::vector<bool>* skip)
 {
+	const size_t shape_count = shape_range.second - shape_range.first;
+	uint64_t shape_mask[Const::max_shapes];
+	int shape_len[Const::max_shapes], min_len = std::numeric_limits<int>::max(), max_len = 0;
+	for (size_t s = 0; s < shape_count; ++s) {
+		const Shape& sh = shapes[shape_range.first + s];
+		shape_mask[s] = sh.long_mask();
+		shape_len[s] = (int)sh.length_;
+		min_len = std::min(min_len, shape_len[s]);
+		max_len = std::max(max_len, shape_len[s]);
+	}
 	uint64_t key;
+	FilteredSeeds<_f, _filter> out(f, filter);
 	for (unsigned i = begin; i < end; ++i) {
 		if (skip && (*skip)[i / align_mode.query_contexts])
 			continue;
 		seqs->convert_to_std_alph(i);
 		const Sequence seq = (*seqs)[i];
-		for (size_t shape_id = shape_range.first; shape_id < shape_range.second; ++shape_id) {
-			const Shape& sh = shapes[shape_id];
-			if (seq.length() < sh.length_) continue;
-			const uint64_t shape_mask = sh.long_mask();
-			//const __m128i shape_mask = sh.long_mask_sse_;
-			Hashed_seed_iterator<_b> it(seq, sh);
-			size_t j = 0;
-			while (it.good()) {
-				if (it.get(key, shape_mask)) {
-					if (filter->contains(key, shape_id))
-						(*f)(key, seqs->position(i, j), i, shape_id);
+		const int len = (int)seq.length();
+		if (len < min_len) continue;
+		const Letter* ptr = seq.data();
+		uint64_t window = 0, prefix_window = 0;
+		// the prefix only differs if it contains a letter that is not an amino acid, and past 2*max_len-2 letters it
+		// is outside of the window of every shape
+		int p = 0, prefix_end = std::min(len, max_len - 1);
+		for (; p < prefix_end; ++p)
+			if (!is_amino_acid(letter_mask(ptr[p])))
+				prefix_end = std::min(len, 2 * max_len - 2);
+		p = 0;
+		for (; p < prefix_end; ++p) {
+			const Letter l = letter_mask(ptr[p]);
+			const uint64_t r = Reduction::reduction(l);
+			prefix_window = (prefix_window << _b) | r;
+			window <<= _b;
+			if (!is_amino_acid(l))
+				continue;
+			window |= r;
+			for (size_t s = 0; s < shape_count; ++s) {
+				const int j = p - shape_len[s] + 1;
+				if (j < 0)
+					continue;
+				uint64_t w = window;
+				// the letters before position shape_len-1 are at bit offsets from (j+1)*_b upwards
+				if (uint64_t(j + 1) * _b < 64) {
+					const uint64_t prefix = ~uint64_t(0) << ((j + 1) * _b);
+					w = (prefix_window & prefix) | (window & ~prefix);
 				}
-				++j;
+				key = murmur_hash()(w & shape_mask[s]);
+				out(key, seqs->position(i, j), i, shape_range.first + s);
 			}
 		}
+		if (shape_count == 1) {
+			const uint64_t mask = shape_mask[0], shape_id = shape_range.first;
+			const int offset = shape_len[0] - 1;
+			for (; p < len; ++p) {
+				const Letter l = letter_mask(ptr[p]);
+				window <<= _b;
+				if (!is_amino_acid(l))
+					continue;
+				window |= Reduction::reduction(l);
+				key = murmur_hash()(window & mask);
+				out(key, seqs->position(i, p - offset), i, shape_id);
+			}
+		}
+		else
+			for (; p < len; ++p) {
+				const Letter l = letter_mask(ptr[p]);
+				window <<= _b;
+				if (!is_amino_acid(l))
+					continue;
+				window |= Reduction::reduction(l);
+				for (size_t s = 0; s < shape_count; ++s) {
+					key = murmur_hash()(window & shape_mask[s]);
+					out(key, seqs->position(i, p - shape_len[s] + 1), i, shape_range.first + s);
+				}
+			}
 	}
+	out.flush();
 	f->finish();
 }
 
@@ -144,6 +280,69 @@ struct No_filter
 
 extern No_filter no_filter;
 
+// Keeps the seeds at the positions of the reference that start a closed syncmer: of the window s-mers of the contiguous
+// span of shape length letters at the seed position (s = length - window + 1), the one with the smallest hash is the
+// first or the last. Seeds of a shape at adjacent positions share all but one s-mer, so that at least one of every
+// window consecutive positions is kept, and about 2/window of them overall. The span and s are taken per shape, since
+// enum_seeds only guarantees the letters of the shape that produced the seed. The query index stays dense, so each kept
+// reference seed is still found by every query that shares it. Requires the SPACED_FACTOR encoding, whose enumeration
+// passes the reduced letters at the seed position.
+struct SyncmerFilter
+{
+	SyncmerFilter(unsigned window):
+		window_(window),
+		base_(Reduction::reduction.size())
+	{
+		if (window < 2 || window > Const::max_seed_weight)
+			throw std::runtime_error("Invalid syncmer window.");
+		for (unsigned i = 0; i < shapes.count(); ++i) {
+			if (window > shapes[i].length_)
+				throw std::runtime_error("Invalid syncmer window.");
+			s_[i] = shapes[i].length_ - window + 1;
+			high_[i] = 1;
+			for (unsigned k = 0; k < s_[i] - 1; ++k)
+				high_[i] *= base_;
+		}
+	}
+	// the hashed and contiguous encodings do not pass the letters of the sequence
+	bool contains(uint64_t seed, uint64_t shape) const
+	{
+		throw std::runtime_error("Seed subsampling requires the spaced seed encoding.");
+	}
+	// seed points to the reduced letters of the sequence at the seed position
+	bool contains(const Letter* seed, uint64_t shape) const
+	{
+		const unsigned s = s_[shape];
+		const uint64_t high = high_[shape];
+		uint64_t h[Const::max_seed_weight], code = 0;
+		for (unsigned k = 0; k < s; ++k)
+			code = code * base_ + (uint64_t)letter_mask(seed[k]);
+		h[0] = murmur_hash()(code);
+		for (unsigned i = 1; i < window_; ++i) {
+			code = (code - (uint64_t)letter_mask(seed[i - 1]) * high) * base_ + (uint64_t)letter_mask(seed[i + s - 1]);
+			h[i] = murmur_hash()(code);
+		}
+		return closed(h);
+	}
+private:
+	// the first minimum of the hashes is at one of the ends, evaluated without branches on the hash values
+	bool closed(const uint64_t* h) const
+	{
+		const uint64_t first = h[0], last = h[window_ - 1];
+		uint64_t inner = std::numeric_limits<uint64_t>::max();
+		for (unsigned i = 1; i < window_ - 1; ++i)
+			inner = std::min(inner, h[i]);
+		return (first <= inner && first <= last) | (last < inner && last < first);
+	}
+	unsigned window_, s_[Const::max_shapes];
+	uint64_t base_, high_[Const::max_shapes];
+};
+
+inline bool filter_contains(const SyncmerFilter* filter, uint64_t key, uint64_t shape, const Letter* seed)
+{
+	return filter->contains(seed, shape);
+}
+
 template <typename _f, typename _filter>
 void enum_seeds(SequenceSet* seqs, PtrVector<_f>& f, const std::vector<size_t>& p, size_t shape_begin, size_t shape_end, const _filter* filter, SeedEncoding code, const std::vector<bool>* skip, bool filter_masked_seeds)
 {
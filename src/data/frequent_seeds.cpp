@@ -22,17 +22,303 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <numeric>
 #include <utility>
 #include <atomic>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <string.h>
 #include "frequent_seeds.h"
 #include "queries.h"
+#include "enum_seeds.h"
+#include "sequence_file.h"
 #include "../util/parallel/thread_pool.h"
 #include "../util/util.h"
+#include "../util/ptr_vector.h"
+#include "../util/hash_function.h"
+#include "../util/io/temp_file.h"
+#include "../util/io/input_file.h"
+#include "../util/system/endianness.h"
+#include "../basic/masking.h"
+#include "../search/search.h"
+#define _REENTRANT
+#include "../lib/ips4o/ips4o.hpp"
 
 using std::endl;
 using std::atomic;
+using std::string;
 
 const double Frequent_seeds::hash_table_factor = 1.3;
 Frequent_seeds frequent_seeds;
 
+// seeds held in memory while counting a bucket, the database seeds are spilled to as many buckets as needed to stay below
+static const size_t MAX_BUCKET_SEEDS = size_t(1) << 27;
+static const size_t MAX_BUCKETS = 256;
+// a bucket that is still too large is split again with a different hash, up to this depth
+static const unsigned MAX_SPLIT_LEVEL = 4;
+
+typedef std::pair<uint32_t, uint64_t> ShapeSeed;
+
+struct SeedCount {
+	uint64_t seed;
+	uint32_t shape, count;
+};
+
+static size_t seed_bucket(uint64_t seed, uint64_t shape, unsigned level, size_t buckets)
+{
+	return murmur_hash()(seed ^ (shape << 56) ^ (uint64_t(level) << 48)) % buckets;
+}
+
+struct SeedSpillCallback
+{
+	SeedSpillCallback(size_t buckets) :
+		buckets(buckets)
+	{}
+	bool operator()(uint64_t seed, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		buckets[seed_bucket(seed, shape, 0, buckets.size())].emplace_back((uint32_t)shape, seed);
+		return true;
+	}
+	void finish()
+	{}
+	vector<vector<ShapeSeed>> buckets;
+};
+
+// Calls f(shape, seed, count) for all distinct seeds of a bucket file.
+template<typename F>
+static void count_bucket(TempFile& file, size_t size, unsigned level, F& f)
+{
+	InputFile in(file);
+	if (size > MAX_BUCKET_SEEDS && level < MAX_SPLIT_LEVEL) {
+		const size_t n = std::min(size / MAX_BUCKET_SEEDS + 1, MAX_BUCKETS);
+		PtrVector<TempFile> out;
+		vector<size_t> sizes(n, 0);
+		for (size_t i = 0; i < n; ++i)
+			out.push_back(new TempFile());
+		vector<ShapeSeed> buf(MAX_BUCKET_SEEDS);
+		size_t m;
+		while ((m = in.read(buf.data(), buf.size())) > 0)
+			for (size_t i = 0; i < m; ++i) {
+				const size_t b = seed_bucket(buf[i].second, buf[i].first, level + 1, n);
+				out[b].write(&buf[i], 1);
+				++sizes[b];
+			}
+		in.close_and_delete();
+		for (size_t i = 0; i < n; ++i)
+			count_bucket(out[i], sizes[i], level + 1, f);
+		return;
+	}
+	vector<ShapeSeed> seeds(size);
+	in.read(seeds.data(), size);
+	in.close_and_delete();
+	ips4o::parallel::sort(seeds.begin(), seeds.end(), std::less<ShapeSeed>(), config.threads_);
+	for (auto j = seeds.cbegin(); j < seeds.cend();) {
+		auto k = j + 1;
+		while (k < seeds.cend() && *k == *j)
+			++k;
+		f(j->first, j->second, uint64_t(k - j));
+		j = k;
+	}
+}
+
+// Calls f(shape, seed, count) for all distinct seeds of the database. The database is read and masked once, its seeds
+// are spilled to bucket files by hash and each bucket is counted in memory.
+template<typename F>
+static void count_seeds(SequenceFile& db, F f)
+{
+	const size_t n = std::min(db.letters() * shapes.count() / MAX_BUCKET_SEEDS + 1, MAX_BUCKETS),
+		load_letters = std::max(MAX_BUCKET_SEEDS / shapes.count(), (size_t)1);
+	PtrVector<TempFile> files;
+	vector<size_t> sizes(n, 0);
+	for (size_t i = 0; i < n; ++i)
+		files.push_back(new TempFile());
+	PtrVector<SeedSpillCallback> cb;
+	for (unsigned i = 0; i < config.threads_; ++i)
+		cb.push_back(new SeedSpillCallback(n));
+	db.set_seqinfo_ptr(0);
+	while (true) {
+		std::unique_ptr<Block> block(db.load_seqs(load_letters, false));
+		if (block->empty())
+			break;
+		SequenceSet& seqs = block->seqs();
+		if (config.masking == 1)
+			mask_seqs(seqs, Masking::get());
+		enum_seeds(&seqs, cb, seqs.partition(config.threads_), 0, shapes.count(), &no_filter, SeedEncoding::SPACED_FACTOR, nullptr, false);
+		for (size_t j = 0; j < cb.size(); ++j)
+			for (size_t i = 0; i < n; ++i) {
+				vector<ShapeSeed>& v = cb[j].buckets[i];
+				files[i].write(v.data(), v.size());
+				sizes[i] += v.size();
+				v.clear();
+			}
+	}
+	for (size_t i = 0; i < n; ++i)
+		count_bucket(files[i], sizes[i], 0, f);
+}
+
+SeedFrequencyTable::SeedFrequencyTable(SequenceFile& db):
+	min_sd(std::numeric_limits<double>::max()),
+	tables(shapes.count())
+{
+	for (const auto& t : sensitivity_traits)
+		min_sd = std::min(min_sd, t.second.freq_sd);
+
+	task_timer timer("Computing seed frequencies");
+	vector<double> n(shapes.count(), 0.0), s2(shapes.count(), 0.0), s3(shapes.count(), 0.0);
+	// the cap is at least the mean group size, which is at least 1, so single seeds are never frequent
+	TempFile repeated;
+	count_seeds(db, [&](unsigned shape, uint64_t seed, uint64_t count) {
+		const double c = (double)count;
+		n[shape] += c;
+		s2[shape] += c * c;
+		s3[shape] += c * c * c;
+		if (count > 1) {
+			const SeedCount r{ seed, shape, (uint32_t)std::min(count, (uint64_t)std::numeric_limits<uint32_t>::max()) };
+			repeated.write(&r, 1);
+		}
+	});
+	std::ostringstream reduction;
+	reduction << Reduction::reduction;
+	for (unsigned i = 0; i < shapes.count(); ++i) {
+		std::ostringstream code;
+		code << shapes[i];
+		tables[i].code = code.str();
+		tables[i].reduction = reduction.str();
+		tables[i].masking = config.masking;
+		tables[i].mean = n[i] > 0.0 ? s2[i] / n[i] : 0.0;
+		tables[i].sd = n[i] > 0.0 ? sqrt(std::max(s3[i] / n[i] - tables[i].mean * tables[i].mean, 0.0)) : 0.0;
+	}
+
+	timer.go("Collecting frequent seeds");
+	InputFile in(repeated);
+	vector<SeedCount> buf(MAX_BUCKET_SEEDS / 2);
+	size_t m;
+	while ((m = in.read(buf.data(), buf.size())) > 0)
+		for (size_t i = 0; i < m; ++i) {
+			ShapeTable& t = tables[buf[i].shape];
+			if (buf[i].count > t.cap(min_sd)) {
+				t.seeds.push_back(buf[i].seed);
+				t.counts.push_back(buf[i].count);
+			}
+		}
+	in.close_and_delete();
+	timer.finish();
+
+	// buckets are formed by hash, so the seeds of a shape need to be sorted for lookups
+	for (ShapeTable& t : tables) {
+		vector<std::pair<uint64_t, uint32_t>> v;
+		for (size_t i = 0; i < t.seeds.size(); ++i)
+			v.emplace_back(t.seeds[i], t.counts[i]);
+		std::sort(v.begin(), v.end());
+		for (size_t i = 0; i < v.size(); ++i) {
+			t.seeds[i] = v[i].first;
+			t.counts[i] = v[i].second;
+		}
+		message_stream << "Shape " << t.code << ": seed group size mean = " << t.mean << ", SD = " << t.sd << ", frequent seeds = " << t.seeds.size() << endl;
+	}
+}
+
+// The table is stored in little endian byte order like the rest of the database file. Doubles are stored by their bit
+// pattern, and the seed and count arrays are written as is on little endian hosts.
+template<typename _t>
+static void read_array(Deserializer& in, vector<_t>& v)
+{
+	in.read(v.data(), v.size());
+	if (!is_little_endian())
+		for (_t& x : v)
+			x = big_endian_byteswap(x);
+}
+
+template<typename _t>
+static void write_array(Serializer& s, const vector<_t>& v)
+{
+	if (is_little_endian())
+		s.write(v.data(), v.size());
+	else
+		for (_t x : v)
+			s.write(big_endian_byteswap(x));
+}
+
+static double read_double(Deserializer& in)
+{
+	uint64_t x;
+	double d;
+	in >> x;
+	memcpy(&d, &x, sizeof(d));
+	return d;
+}
+
+static void write_double(Serializer& s, double d)
+{
+	uint64_t x;
+	memcpy(&x, &d, sizeof(d));
+	s << x;
+}
+
+SeedFrequencyTable::SeedFrequencyTable(Deserializer& in)
+{
+	in.varint = false;
+	uint64_t n, m;
+	min_sd = read_double(in);
+	in >> n;
+	tables.resize(n);
+	for (ShapeTable& t : tables) {
+		uint32_t masking;
+		in >> t.code >> t.reduction >> masking;
+		t.masking = (int)masking;
+		t.mean = read_double(in);
+		t.sd = read_double(in);
+		in >> m;
+		t.seeds.resize(m);
+		t.counts.resize(m);
+		read_array(in, t.seeds);
+		read_array(in, t.counts);
+	}
+}
+
+Serializer& operator<<(Serializer& s, const SeedFrequencyTable& t)
+{
+	s.unset(Serializer::VARINT);
+	write_double(s, t.min_sd);
+	s << (uint64_t)t.tables.size();
+	for (const SeedFrequencyTable::ShapeTable& i : t.tables) {
+		s << i.code << i.reduction << (uint32_t)i.masking;
+		write_double(s, i.mean);
+		write_double(s, i.sd);
+		s << (uint64_t)i.seeds.size();
+		write_array(s, i.seeds);
+		write_array(s, i.counts);
+	}
+	return s;
+}
+
+uint32_t SeedFrequencyTable::ShapeTable::count(uint64_t seed) const
+{
+	const auto i = std::lower_bound(seeds.begin(), seeds.end(), seed);
+	return i != seeds.end() && *i == seed ? counts[i - seeds.begin()] : 0;
+}
+
+const SeedFrequencyTable::ShapeTable* SeedFrequencyTable::get(const Shape& shape, double freq_sd, int masking) const
+{
+	if (freq_sd < min_sd)
+		return nullptr;
+	std::ostringstream code, reduction;
+	code << shape;
+	reduction << Reduction::reduction;
+	for (const ShapeTable& t : tables)
+		if (t.code == code.str() && t.reduction == reduction.str() && t.masking == masking)
+			return &t;
+	return nullptr;
+}
+
+// Same value as the seed iterator of the SPACED_FACTOR encoding, computed from unreduced letters that may carry the
+// seed mask bit.
+uint64_t SeedFrequencyTable::seed(const Shape& shape, const Letter* seq)
+{
+	uint64_t s = 0;
+	for (unsigned i = 0; i < shape.weight_; ++i)
+		s = s * Reduction::reduction.size() + Reduction::reduction(letter_mask(seq[shape.positions_[i]]));
+	return s;
+}
+
 static void compute_sd(atomic<unsigned> *seedp, DoubleArray<SeedArray::Entry::Value> *query_seed_hits, DoubleArray<SeedArray::Entry::Value> *ref_seed_hits, vector<Sd> *ref_out, vector<Sd> *query_out)
 {
 	unsigned p;
@@ -56,6 +342,7 @@ void Frequent_seeds::build_worker(
 	unsigned sid,
 	unsigned ref_max_n,
 	unsigned query_max_n,
+	const SeedFrequencyTable::ShapeTable* table,
 	vector<unsigned> *counts,
 	Search::Config* cfg) {
 	SequenceSet& query_seqs = cfg->query->seqs();
@@ -65,11 +352,9 @@ void Frequent_seeds::build_worker(
 	vector<uint32_t> buf;
 	size_t n = 0;
 	for (auto it = JoinIterator<SeedArray::Entry::Value>(query_seed_hits[seedp].begin(), ref_seed_hits[seedp].begin()); it;) {
-		if (it.s->size() > ref_max_n || it.r->size() > query_max_n) {
+		const size_t ref_n = table ? table->count(SeedFrequencyTable::seed(shapes[sid], query_seqs.data(*it.r->begin()))) : it.s->size();
+		if (ref_n > ref_max_n || it.r->size() > query_max_n) {
 			n += (unsigned)it.s->size();
-			//Packed_seed s;
-			//shapes[sid].set_seed(s, query_seqs::get().data(*it.r->begin()));
-			//buf.push_back(seed_partition_offset(s));
 
 			Range<SeedArray::Entry::Value*> query_hits = *it.r;
 			for (SeedArray::Entry::Value* i = query_hits.begin(); i < query_hits.end(); ++i) {
@@ -89,6 +374,10 @@ void Frequent_seeds::build_worker(
 
 void Frequent_seeds::build(unsigned sid, const SeedPartitionRange &range, DoubleArray<SeedArray::Entry::Value> *query_seed_hits, DoubleArray<SeedArray::Entry::Value> *ref_seed_hits, Search::Config& cfg)
 {
+	vector<unsigned> counts(Const::seedp);
+	// the table only applies if the reference seeds of this search were masked like the counted ones
+	const int ref_masking = config.masking == 1 && !config.no_ref_masking && !cfg.lazy_masking ? 1 : 0;
+	const SeedFrequencyTable::ShapeTable* table = cfg.seed_freq ? cfg.seed_freq->get(shapes[sid], cfg.freq_sd, ref_masking) : nullptr;
 	vector<Sd> ref_sds(range.size()), query_sds(range.size());
 	atomic<unsigned> seedp(range.begin());
 	vector<std::thread> threads;
@@ -98,12 +387,15 @@ void Frequent_seeds::build(unsigned sid, const SeedPartitionRange &range, Double
 		t.join();
 
 	Sd ref_sd(ref_sds), query_sd(query_sds);
-	const unsigned ref_max_n = (unsigned)(ref_sd.mean() + cfg.freq_sd*ref_sd.sd()), query_max_n = (unsigned)(query_sd.mean() + cfg.freq_sd*query_sd.sd());
-	log_stream << "Seed frequency mean (reference) = " << ref_sd.mean() << ", SD = " << ref_sd.sd() << endl;
+	// with a database table, reference groups are capped by their database-wide count, which does not depend on the block
+	const unsigned ref_max_n = table ? table->cap(cfg.freq_sd) : (unsigned)(ref_sd.mean() + cfg.freq_sd*ref_sd.sd()), query_max_n = (unsigned)(query_sd.mean() + cfg.freq_sd*query_sd.sd());
+	if (table)
+		log_stream << "Seed frequency mean (reference, database) = " << table->mean << ", SD = " << table->sd << endl;
+	else
+		log_stream << "Seed frequency mean (reference) = " << ref_sd.mean() << ", SD = " << ref_sd.sd() << endl;
 	log_stream << "Seed frequency mean (query) = " << query_sd.mean() << ", SD = " << query_sd.sd() << endl;
 	log_stream << "Seed frequency cap query: " << query_max_n << ", reference: " << ref_max_n << endl;
-	vector<unsigned> counts(Const::seedp);
-	Util::Parallel::scheduled_thread_pool_auto(config.threads_, Const::seedp, build_worker, query_seed_hits, ref_seed_hits, &range, sid, ref_max_n, query_max_n, &counts, &cfg);
+	Util::Parallel::scheduled_thread_pool_auto(config.threads_, Const::seedp, build_worker, query_seed_hits, ref_seed_hits, &range, sid, ref_max_n, query_max_n, table, &counts, &cfg);
 	log_stream << "Masked positions = " << std::accumulate(counts.begin(), counts.end(), 0) << std::endl;
 }
 
@@ -27,6 +27,44 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util/algo/join_result.h"
 #include "../util/range.h"
 #include "../run/config.h"
+#include "../util/io/serializer.h"
+#include "../util/io/deserializer.h"
+#include "../basic/shape.h"
+
+struct SequenceFile;
+
+// Database-wide seed counts for the shapes that were active when the table was built (makedb --freq-table). Seed
+// groups are weighted by their size, so that mean and SD describe the group a random seed occurrence falls into, which
+// is what the seed join sees. Only the seeds above the lowest cap of any sensitivity mode are stored.
+struct SeedFrequencyTable
+{
+
+	struct ShapeTable {
+		uint32_t count(uint64_t seed) const;
+		unsigned cap(double freq_sd) const {
+			return (unsigned)(mean + freq_sd * sd);
+		}
+		// shape code, reduction and masking (--masking) of the database seeds that were counted
+		std::string code, reduction;
+		int masking;
+		double mean, sd;
+		std::vector<uint64_t> seeds;
+		std::vector<uint32_t> counts;
+	};
+
+	SeedFrequencyTable(SequenceFile& db);
+	SeedFrequencyTable(Deserializer& in);
+	// Returns nullptr if the table was built for a different shape, reduction or masking of the reference, or does not hold
+	// all seeds above the cap for freq_sd.
+	const ShapeTable* get(const Shape& shape, double freq_sd, int masking) const;
+	static uint64_t seed(const Shape& shape, const Letter* seq);
+
+	double min_sd;
+	std::vector<ShapeTable> tables;
+
+	friend Serializer& operator<<(Serializer& s, const SeedFrequencyTable& t);
+
+};
 
 struct Frequent_seeds
 {
@@ -47,6 +85,7 @@ private:
 		unsigned sid,
 		unsigned ref_max_n,
 		unsigned query_max_n,
+		const SeedFrequencyTable::ShapeTable* table,
 		vector<unsigned> *counts,
 		Search::Config* cfg);
 
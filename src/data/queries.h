@@ -37,6 +37,6 @@ void write_unaligned(const Block& query, OutputFile *file);
 void write_aligned(const Block& query, OutputFile *file);
 
 struct HashedSeedSet;
-struct SeedSet;
+struct ContiguousSeedIndex;
 extern std::unique_ptr<HashedSeedSet> query_seeds_hashed;
-extern std::unique_ptr<SeedSet> query_seeds_bitset;
\ No newline at end of file
+extern std::unique_ptr<ContiguousSeedIndex> query_seeds_ctg;
\ No newline at end of file
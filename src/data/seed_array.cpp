@@ -135,8 +135,8 @@ SeedArray::SeedArray(SequenceSet &seqs, size_t shape, const shape_histogram &hst
 }
 
 template SeedArray::SeedArray(SequenceSet &, size_t, const shape_histogram &, const SeedPartitionRange &, const vector<size_t>&, char *buffer, const No_filter *, const SeedEncoding, const std::vector<bool>*);
-template SeedArray::SeedArray(SequenceSet &, size_t, const shape_histogram &, const SeedPartitionRange &, const vector<size_t>&, char *buffer, const SeedSet *, const SeedEncoding, const std::vector<bool>*);
 template SeedArray::SeedArray(SequenceSet &, size_t, const shape_histogram &, const SeedPartitionRange &, const vector<size_t>&, char *buffer, const HashedSeedSet *, const SeedEncoding, const std::vector<bool>*);
+template SeedArray::SeedArray(SequenceSet &, size_t, const shape_histogram &, const SeedPartitionRange &, const vector<size_t>&, char *buffer, const SyncmerFilter *, const SeedEncoding, const std::vector<bool>*);
 
 struct BufferedWriter2
 {
@@ -37,38 +37,189 @@ using std::runtime_error;
 
 No_filter no_filter;
 
-struct Seed_set_callback
+struct Seed_mark_callback
 {
-	Seed_set_callback(vector<bool> &data, size_t max_coverage):
-		coverage(0),
-		max_coverage(max_coverage),
-		data(&data)
+	Seed_mark_callback(vector<uint64_t>& bits):
+		bits(bits)
 	{}
 	bool operator()(uint64_t seed, uint64_t pos, uint32_t block_id, uint64_t shape)
 	{
-		if ((*data)[seed] == false) {
-			(*data)[seed] = true;
-			++coverage;
-			if (coverage > max_coverage)
-				return false;
-		}
+		bits[seed >> 6] |= uint64_t(1) << (seed & 63);
+		return true;
+	}
+	void finish()
+	{}
+	vector<uint64_t>& bits;
+};
+
+struct Seed_count_callback
+{
+	Seed_count_callback(const ContiguousSeedIndex& index, vector<uint32_t>& count):
+		index(index),
+		count(count)
+	{}
+	bool operator()(uint64_t seed, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		++count[index.id(seed) + 1];
+		return true;
+	}
+	void finish()
+	{}
+	const ContiguousSeedIndex& index;
+	vector<uint32_t>& count;
+};
+
+struct Seed_position_callback
+{
+	Seed_position_callback(const ContiguousSeedIndex& index, vector<uint32_t>& next, vector<PackedLoc>& positions):
+		index(index),
+		next(next),
+		positions(positions)
+	{}
+	bool operator()(uint64_t seed, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		positions[next[index.id(seed)]++] = pos;
 		return true;
 	}
 	void finish()
 	{}
-	size_t coverage, max_coverage;
-	vector<bool> *data;
+	const ContiguousSeedIndex& index;
+	vector<uint32_t>& next;
+	vector<PackedLoc>& positions;
 };
 
-SeedSet::SeedSet(SequenceSet &seqs, double max_coverage, const std::vector<bool>* skip):
-	data_((size_t)pow(1llu<<Reduction::reduction.bit_size(), shapes[0].length_))
+ContiguousSeedIndex::ContiguousSeedIndex(SequenceSet &seqs, const std::vector<bool>* skip):
+	bits_(((uint64_t(1) << (shapes[0].length_ * Reduction::reduction.bit_size())) + 63) / 64, 0),
+	partition_begin_(Const::seedp + 1, 0)
 {
 	if (!shapes[0].contiguous())
 		throw std::runtime_error("Contiguous seed required.");
-	PtrVector<Seed_set_callback> v;
-	v.push_back(new Seed_set_callback(data_, size_t(max_coverage*pow(Reduction::reduction.size(), shapes[0].length_))));
-	enum_seeds(&seqs, v, seqs.partition(1), 0, 1, &no_filter, SeedEncoding::CONTIGUOUS, skip, true);
-	coverage_ = (double)v.back().coverage / pow(Reduction::reduction.size(), shapes[0].length_);
+	const vector<size_t> p = seqs.partition(1);
+	{
+		PtrVector<Seed_mark_callback> v;
+		v.push_back(new Seed_mark_callback(bits_));
+		enum_seeds(&seqs, v, p, 0, 1, &no_filter, SeedEncoding::CONTIGUOUS, skip, true);
+	}
+
+	rank_.resize(bits_.size());
+	uint32_t n = 0;
+	for (size_t i = 0; i < bits_.size(); ++i) {
+		rank_[i] = n;
+		n += (uint32_t)popcount64(bits_[i]);
+	}
+
+	// ids ascend with the key, so a stable counting sort by partition keeps the keys of a partition in order
+	vector<uint64_t> key;
+	key.reserve(n);
+	for (size_t i = 0; i < bits_.size(); ++i)
+		for (uint64_t w = bits_[i]; w; w &= w - 1)
+			key.push_back((i << 6) | ctz(w));
+	for (uint64_t k : key)
+		++partition_begin_[seed_partition(k) + 1];
+	for (unsigned i = 0; i < Const::seedp; ++i)
+		partition_begin_[i + 1] += partition_begin_[i];
+	order_.resize(n);
+	vector<uint32_t> next(partition_begin_.begin(), partition_begin_.end() - 1);
+	for (uint32_t i = 0; i < n; ++i)
+		order_[next[seed_partition(key[i])]++] = i;
+
+	begin_.assign(n + 1, 0);
+	{
+		PtrVector<Seed_count_callback> v;
+		v.push_back(new Seed_count_callback(*this, begin_));
+		enum_seeds(&seqs, v, p, 0, 1, this, SeedEncoding::CONTIGUOUS, skip, false);
+	}
+	for (uint32_t i = 0; i < n; ++i)
+		begin_[i + 1] += begin_[i];
+	positions_.resize(begin_.back());
+	next.assign(begin_.begin(), begin_.end() - 1);
+	PtrVector<Seed_position_callback> v;
+	v.push_back(new Seed_position_callback(*this, next, positions_));
+	enum_seeds(&seqs, v, p, 0, 1, this, SeedEncoding::CONTIGUOUS, skip, false);
+}
+
+#pragma pack(1)
+
+struct Seed_hit
+{
+	uint32_t id;
+	PackedLoc pos;
+} PACKED_ATTRIBUTE;
+
+#pragma pack()
+
+struct Seed_join_callback
+{
+	Seed_join_callback(const ContiguousSeedIndex& index, const SeedPartitionRange& range):
+		index(index),
+		range(range)
+	{}
+	bool operator()(uint64_t seed, uint64_t pos, uint32_t block_id, uint64_t shape)
+	{
+		if (!range.contains(seed_partition(seed)))
+			return true;
+		hits.push_back({ index.id(seed), pos });
+		return true;
+	}
+	void finish()
+	{}
+	const ContiguousSeedIndex& index;
+	const SeedPartitionRange range;
+	vector<Seed_hit> hits;
+};
+
+// The reference is enumerated in parallel over consecutive ranges of sequences. The hits of each thread are then
+// scattered in thread order, so that the reference positions of a group are in sequence order, as in a seed array.
+void ContiguousSeedIndex::join(SequenceSet& ref_seqs, const SeedPartitionRange& range, DoubleArray<PackedLoc>* query_hits, DoubleArray<PackedLoc>* ref_hits)
+{
+	PtrVector<Seed_join_callback> cb;
+	const vector<size_t> p = ref_seqs.partition(config.threads_);
+	for (size_t i = 0; i < p.size() - 1; ++i)
+		cb.push_back(new Seed_join_callback(*this, range));
+	enum_seeds(&ref_seqs, cb, p, 0, 1, this, SeedEncoding::CONTIGUOUS, nullptr, false);
+
+	vector<size_t> next(keys(), 0);
+	for (const Seed_join_callback* c : cb)
+		for (const Seed_hit& h : c->hits)
+			++next[h.id];
+
+	size_t query_size = 0, ref_size = 0;
+	for (uint32_t i = partition_begin_[range.begin()]; i < partition_begin_[range.end()]; ++i) {
+		const uint32_t id = order_[i];
+		if (next[id]) {
+			query_size += 4 + (begin_[id + 1] - begin_[id]) * sizeof(PackedLoc);
+			ref_size += 4 + next[id] * sizeof(PackedLoc);
+		}
+	}
+	query_buf_.resize(query_size);
+	ref_buf_.resize(ref_size);
+
+	char* q = query_buf_.data(), *r = ref_buf_.data();
+	for (unsigned i = range.begin(); i < range.end(); ++i) {
+		char* const q0 = q, *const r0 = r;
+		for (uint32_t j = partition_begin_[i]; j < partition_begin_[i + 1]; ++j) {
+			const uint32_t id = order_[j];
+			if (next[id] == 0)
+				continue;
+			const uint32_t n = begin_[id + 1] - begin_[id];
+			*(uint32_t*)q = n;
+			memcpy(q + 4, &positions_[begin_[id]], n * sizeof(PackedLoc));
+			q += 4 + n * sizeof(PackedLoc);
+			*(uint32_t*)r = (uint32_t)next[id];
+			r += 4;
+			const size_t s = next[id];
+			next[id] = r - ref_buf_.data();
+			r += s * sizeof(PackedLoc);
+		}
+		query_hits[i] = DoubleArray<PackedLoc>(q0, q - q0);
+		ref_hits[i] = DoubleArray<PackedLoc>(r0, r - r0);
+	}
+
+	for (const Seed_join_callback* c : cb)
+		for (const Seed_hit& h : c->hits) {
+			memcpy(ref_buf_.data() + next[h.id], &h.pos, sizeof(PackedLoc));
+			next[h.id] += sizeof(PackedLoc);
+		}
 }
 
 struct Hashed_seed_set_callback
@@ -115,6 +266,7 @@ HashedSeedSet::HashedSeedSet(const string& index_file):
 	if (mmap_->length() < SEED_INDEX_HEADER_SIZE)
 		throw runtime_error("Invalid seed index file.");
 	const char* buf = mmap_->data();
+	Util::Memory::advise_huge_pages(buf, mmap_->length());
 	if (*(uint64_t*)buf != SEED_INDEX_MAGIC_NUMBER)
 		throw runtime_error("Invalid seed index file.");
 	if (*(uint32_t*)(buf + 8) != SEED_INDEX_VERSION)
@@ -22,6 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include <vector>
 #include "sequence_set.h"
+#include "enum_seeds.h"
+#include "seed_histogram.h"
+#include "../basic/packed_loc.h"
+#include "../util/data_structures/double_array.h"
+#include "../util/intrin.h"
 #include "../util/hash_table.h"
 #include "../util/ptr_vector.h"
 #include "../util/data_structures/hash_set.h"
@@ -32,25 +37,49 @@ const uint64_t SEED_INDEX_MAGIC_NUMBER = 0x2d6ba306ecbf6aba;
 const uint32_t SEED_INDEX_VERSION = 0;
 const size_t SEED_INDEX_HEADER_SIZE = 16;
 
-struct SeedSet
+// Direct-addressed index of the query seeds of the contiguous seed mode. The key space of a contiguous seed over the
+// reduced alphabet is small enough for a table over all keys, so the query positions are laid out by a counting sort
+// and the reference seeds are joined against the table in one streaming pass, without building and clustering a
+// reference seed array. Only the keys of seeds without masked letters are indexed, with all their positions.
+struct ContiguousSeedIndex
 {
-	SeedSet(SequenceSet &seqs, double max_coverage, const std::vector<bool>* skip);
+	ContiguousSeedIndex(SequenceSet &seqs, const std::vector<bool>* skip);
+	// Joins the reference seeds of the partitions in range against the index. The seed groups of partition p are
+	// stored in query_hits[p] and ref_hits[p] in the layout of hash_join and stay valid until the next call.
+	void join(SequenceSet& ref_seqs, const SeedPartitionRange& range, DoubleArray<PackedLoc>* query_hits, DoubleArray<PackedLoc>* ref_hits);
 	bool contains(uint64_t key, uint64_t shape) const
 	{
-		return data_[key];
+		return (bits_[key >> 6] >> (key & 63)) & 1;
 	}
-	double coverage() const
+	// Id of an indexed key in [0, keys()), in the order of the keys.
+	uint32_t id(uint64_t key) const
 	{
-		return coverage_;
+		return rank_[key >> 6] + (uint32_t)popcount64(bits_[key >> 6] & ((uint64_t(1) << (key & 63)) - 1));
+	}
+	size_t keys() const
+	{
+		return begin_.size() - 1;
+	}
+	size_t size() const
+	{
+		return positions_.size();
 	}
 private:
-	std::vector<bool> data_;
-	double coverage_;
+	// The indexed keys are a bitmap over the key space with the number of keys before each word, which gives the ids
+	// and keeps the table that every reference seed probes at the size of a bitmap. begin_ holds the offsets of the
+	// positions of the ids, order_ the ids sorted by seed partition and partition_begin_ the start of each partition
+	// in order_.
+	std::vector<uint64_t> bits_;
+	std::vector<uint32_t> rank_, begin_, order_, partition_begin_;
+	std::vector<PackedLoc> positions_;
+	std::vector<char> query_buf_, ref_buf_;
 };
 
 struct HashedSeedSet
 {
 	typedef HashSet<Modulo2, Identity> Table;
+	// seeds per call of the batched contains()
+	static const size_t BATCH = 32;
 	HashedSeedSet(SequenceSet &seqs, const std::vector<bool>* skip);
 	HashedSeedSet(const string& index_file);
 	~HashedSeedSet();
@@ -58,6 +87,18 @@ struct HashedSeedSet
 	{
 		return data_[shape].contains(key);
 	}
+	// Tests n <= BATCH seeds. The buckets of all seeds are prefetched before the first one is compared, so that the
+	// cache and TLB misses of the probes overlap instead of being waited for one after another.
+	void contains(const uint64_t* keys, const uint64_t* shape, size_t n, bool* out) const
+	{
+		const Table::fp* p[BATCH];
+		for (size_t i = 0; i < n; ++i) {
+			p[i] = data_[shape[i]].bucket(keys[i]);
+			Table::prefetch(p[i]);
+		}
+		for (size_t i = 0; i < n; ++i)
+			out[i] = data_[shape[i]].contains(keys[i], p[i]);
+	}
 	const Table& table(size_t i) const {
 		return data_[i];
 	}
@@ -66,3 +107,9 @@ private:
 	PtrVector<Table> data_;
 	std::unique_ptr<mio::mmap_source> mmap_;
 };
+
+template<>
+struct FilterBatch<HashedSeedSet>
+{
+	static const size_t SIZE = HashedSeedSet::BATCH;
+};
@@ -186,6 +186,9 @@ void SequenceFile::get_seq()
 		list.close();
 	}
 
+	// with an accession list, only the selected sequences are read using random access
+	std::unique_ptr<BitVector> filter(config.seqidlist.empty() ? nullptr : filter_by_accession(config.seqidlist));
+
 	vector<Letter> seq;
 	string id;
 	bool all = config.seq_no.size() == 0 && seq_titles.empty();
@@ -198,6 +201,11 @@ void SequenceFile::get_seq()
 	TextBuffer buf;
 	OutputFile out(config.output_file);
 	for (size_t n = 0; n < sequence_count(); ++n) {
+		if (filter) {
+			if (!filter->get(n))
+				continue;
+			seek_seq(n);
+		}
 		read_seq(seq, id);
 		std::map<string, string>::const_iterator mapped_title = seq_titles.find(Util::Seq::seqid(id.c_str(), false));
 		if (all || seqs.find(n) != seqs.end() || mapped_title != seq_titles.end()) {
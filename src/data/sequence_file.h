@@ -29,6 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util/data_structures/bit_vector.h"
 #include "block.h"
 
+struct SeedFrequencyTable;
+
 struct Chunk
 {
 	Chunk() : i(0), offset(0), n_seqs(0)
@@ -81,6 +83,7 @@ struct SequenceFile {
 
 	virtual void init_seqinfo_access() = 0;
 	virtual void init_seq_access() = 0;
+	virtual void seek_seq(size_t oid) = 0;
 	virtual void seek_chunk(const Chunk& chunk) = 0;
 	virtual size_t tell_seq() const = 0;
 	virtual SeqInfo read_seqinfo() = 0;
@@ -112,6 +115,7 @@ struct SequenceFile {
 	virtual void close_weakly() = 0;
 	virtual void reopen() = 0;
 	virtual BitVector* filter_by_accession(const std::string& file_name) = 0;
+	virtual SeedFrequencyTable* seed_freq_table() = 0;
 	virtual BitVector* filter_by_taxonomy(const std::string& include, const std::string& exclude, TaxonomyNodes& nodes) = 0;
 	virtual std::vector<unsigned> taxids(size_t oid) const = 0;
 	virtual const BitVector* builtin_filter() = 0;
@@ -85,7 +85,7 @@ static void load_mapping_file(ExternalSorter<pair<string, uint32_t>>& sorter)
 	f.close();
 }
 
-void TaxonList::build(OutputFile &db, ExternalSorter<pair<string, uint32_t>>& acc2oid, size_t seqs, Table& stats)
+void TaxonList::build(OutputFile &db, ExternalSorter<pair<string, uint32_t>>& acc2oid, size_t seqs, Table& stats, ExternalSorter<TaxidOid>& taxid2oid)
 {
 	typedef pair<string, uint32_t> T;
 
@@ -118,6 +118,8 @@ void TaxonList::build(OutputFile &db, ExternalSorter<pair<string, uint32_t>>& ac
 		set<uint32_t> tax_ids = *taxid_it;
 		tax_ids.erase(0);
 		db << tax_ids;
+		for (uint32_t t : tax_ids)
+			taxid2oid.push({ t, taxid_it.key() });
 		++taxid_it;
 		if (!tax_ids.empty())
 			++mapped_seqs;
@@ -129,3 +131,31 @@ void TaxonList::build(OutputFile &db, ExternalSorter<pair<string, uint32_t>>& ac
 	stats("Database accessions mapped to taxid" , acc_matched);
 	stats("Database sequences mapped to taxid", mapped_seqs);
 }
+
+uint64_t TaxonList::build_index(OutputFile &db, ExternalSorter<TaxidOid>& taxid2oid)
+{
+	task_timer timer("Writing taxon index");
+	db.unset(Serializer::VARINT);
+	taxid2oid.init_read();
+	const uint64_t data_offset = db.tell();
+	vector<uint32_t> taxids;
+	vector<uint64_t> limits;
+	uint64_t n = 0;
+	while (taxid2oid.good()) {
+		const TaxidOid p = *taxid2oid;
+		if (taxids.empty() || taxids.back() != p.first) {
+			taxids.push_back(p.first);
+			limits.push_back(n);
+		}
+		db << p.second;
+		++n;
+		++taxid2oid;
+	}
+	limits.push_back(n);
+
+	const uint64_t table_offset = db.tell();
+	db << data_offset << taxids << (uint64_t)limits.size();
+	for (uint64_t i : limits)
+		db << i;
+	return table_offset;
+}
@@ -30,6 +30,9 @@ struct ExternalSorter;
 struct TaxonList : public CompactArray<vector<unsigned>>
 {
 	typedef std::pair<std::string, uint32_t> T;
+	typedef std::pair<uint32_t, uint32_t> TaxidOid;
 	TaxonList(Deserializer &in, size_t size, size_t data_size);
-	static void build(OutputFile &db, ExternalSorter<T, std::less<T>>& accessions, size_t seqs, Table& stats);
+	static void build(OutputFile &db, ExternalSorter<T, std::less<T>>& accessions, size_t seqs, Table& stats, ExternalSorter<TaxidOid, std::less<TaxidOid>>& taxid2oid);
+	// Writes the inverted taxon index (sorted OID list per taxon id), returns the offset of its table.
+	static uint64_t build_index(OutputFile &db, ExternalSorter<TaxidOid, std::less<TaxidOid>>& taxid2oid);
 };
\ No newline at end of file
@@ -18,10 +18,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <set>
 #include <iomanip>
+#include <limits>
 #include "taxonomy_nodes.h"
 #include "taxonomy.h"
 #include "../util/log_stream.h"
 #include "../util/string/string.h"
+#include "../util/intrin.h"
 
 using namespace std;
 
@@ -56,9 +58,105 @@ TaxonomyNodes::TaxonomyNodes(Deserializer &in, uint32_t db_build)
 	}
 	cached_.insert(cached_.end(), parent_.size(), false);
 	contained_.insert(contained_.end(), parent_.size(), false);
+	build_lca_index();
+}
+
+void TaxonomyNodes::build_lca_index()
+{
+	static const uint32_t NONE = numeric_limits<uint32_t>::max();
+	const uint32_t n = (uint32_t)parent_.size();
+	preorder_pos_.assign(n, NONE);
+	if (n < 2 || parent_[1] != 1)
+		return;
+
+	vector<uint32_t> child_begin(n + 1, 0), children;
+	for (uint32_t i = 2; i < n; ++i)
+		if (parent_[i] != 0 && parent_[i] != i && parent_[i] < n)
+			++child_begin[parent_[i] + 1];
+	for (uint32_t i = 0; i < n; ++i)
+		child_begin[i + 1] += child_begin[i];
+	children.resize(child_begin[n]);
+	vector<uint32_t> fill(child_begin.begin(), child_begin.end() - 1);
+	for (uint32_t i = 2; i < n; ++i)
+		if (parent_[i] != 0 && parent_[i] != i && parent_[i] < n)
+			children[fill[parent_[i]]++] = i;
+	vector<uint32_t>().swap(fill);
+
+	// Nodes below the maximum depth are left out, queries involving them use the parent walk which reports the error.
+	vector<pair<uint32_t, uint8_t>> stack;
+	stack.emplace_back(1, 0);
+	while (!stack.empty()) {
+		const uint32_t node = stack.back().first;
+		const uint8_t depth = stack.back().second;
+		stack.pop_back();
+		preorder_pos_[node] = (uint32_t)preorder_node_.size();
+		preorder_node_.push_back(node);
+		preorder_depth_.push_back(depth);
+		if (depth < LCA_MAX_DEPTH)
+			for (uint32_t i = child_begin[node]; i < child_begin[node + 1]; ++i)
+				stack.emplace_back(children[i], depth + 1);
+	}
+
+	const uint32_t blocks = ((uint32_t)preorder_node_.size() + LCA_BLOCK - 1) >> LCA_BLOCK_SHIFT;
+	block_min_.emplace_back(blocks);
+	for (uint32_t b = 0; b < blocks; ++b)
+		block_min_[0][b] = min_depth_pos(b << LCA_BLOCK_SHIFT, std::min((b + 1) << LCA_BLOCK_SHIFT, (uint32_t)preorder_node_.size()));
+	for (uint32_t k = 1; (1u << k) <= blocks; ++k) {
+		const vector<uint32_t>& prev = block_min_[k - 1];
+		vector<uint32_t> level(blocks - (1u << k) + 1);
+		for (uint32_t b = 0; b < level.size(); ++b) {
+			const uint32_t i = prev[b], j = prev[b + (1u << (k - 1))];
+			level[b] = preorder_depth_[j] < preorder_depth_[i] ? j : i;
+		}
+		block_min_.push_back(move(level));
+	}
+}
+
+uint32_t TaxonomyNodes::min_depth_pos(uint32_t begin, uint32_t end) const
+{
+	uint32_t r = begin;
+	for (uint32_t i = begin + 1; i < end; ++i)
+		if (preorder_depth_[i] < preorder_depth_[r])
+			r = i;
+	return r;
 }
 
 unsigned TaxonomyNodes::get_lca(unsigned t1, unsigned t2) const
+{
+	static const uint32_t NONE = numeric_limits<uint32_t>::max();
+	if (t1 == t2 || t2 == 0)
+		return t1;
+	if (t1 == 0)
+		return t2;
+	if (t1 >= preorder_pos_.size() || t2 >= preorder_pos_.size() || preorder_pos_[t1] == NONE || preorder_pos_[t2] == NONE)
+		return get_lca_walk(t1, t2);
+
+	uint32_t begin = preorder_pos_[t1], end = preorder_pos_[t2];
+	if (begin > end)
+		std::swap(begin, end);
+	++begin;
+	++end;
+	const uint32_t b0 = begin >> LCA_BLOCK_SHIFT, b1 = (end - 1) >> LCA_BLOCK_SHIFT;
+	uint32_t r;
+	if (b0 == b1)
+		r = min_depth_pos(begin, end);
+	else {
+		r = min_depth_pos(begin, (b0 + 1) << LCA_BLOCK_SHIFT);
+		const uint32_t j = min_depth_pos(b1 << LCA_BLOCK_SHIFT, end);
+		if (preorder_depth_[j] < preorder_depth_[r])
+			r = j;
+		if (b1 - b0 > 1) {
+			const uint32_t k = 31 - clz(b1 - b0 - 1), i1 = block_min_[k][b0 + 1], i2 = block_min_[k][b1 - (1u << k)];
+			if (preorder_depth_[i1] < preorder_depth_[r])
+				r = i1;
+			if (preorder_depth_[i2] < preorder_depth_[r])
+				r = i2;
+		}
+	}
+	return parent_[preorder_node_[r]];
+}
+
+unsigned TaxonomyNodes::get_lca_walk(unsigned t1, unsigned t2) const
 {
 	static const int max = 64;
 	if (t1 == t2 || t2 == 0)
@@ -68,6 +68,7 @@ struct TaxonomyNodes
 	}
 	unsigned rank_taxid(unsigned taxid, Rank rank) const;
 	std::set<unsigned> rank_taxid(const std::vector<unsigned> &taxid, Rank rank) const;
+	// Thread-safe, allocation-free LCA using the index built at load time.
 	unsigned get_lca(unsigned t1, unsigned t2) const;
 	bool contained(unsigned query, const std::set<unsigned> &filter);
 	bool contained(const std::vector<unsigned> query, const std::set<unsigned> &filter);
@@ -80,8 +81,19 @@ private:
 		contained_[taxon_id] = contained;
 	}
 
+	// Preorder of the tree rooted at 1 with a block sparse table over the node depths. For preorder positions a < b,
+	// the node of minimum depth in (a, b] is a child of the LCA.
+	void build_lca_index();
+	uint32_t min_depth_pos(uint32_t begin, uint32_t end) const;
+	unsigned get_lca_walk(unsigned t1, unsigned t2) const;
+
+	enum { LCA_BLOCK_SHIFT = 5, LCA_BLOCK = 1 << LCA_BLOCK_SHIFT, LCA_MAX_DEPTH = 64 };
+
 	std::vector<uint32_t> parent_;
 	std::vector<Rank> rank_;
 	std::vector<bool> cached_, contained_;
+	std::vector<uint32_t> preorder_pos_, preorder_node_;
+	std::vector<uint8_t> preorder_depth_;
+	std::vector<std::vector<uint32_t>> block_min_;
 
 };
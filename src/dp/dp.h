@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../basic/config.h"
 #include "../util/dynamic_iterator.h"
 #include "../stats/cbs.h"
+#include "score_profile.h"
 
 int smith_waterman(const Sequence&query, const Sequence&subject, unsigned band, unsigned padding, int op, int ep);
 
@@ -237,6 +238,7 @@ namespace DP {
 struct Traceback {};
 struct StatTraceback {};
 struct VectorTraceback {};
+struct CheckpointTraceback {};
 struct ScoreOnly {};
 struct ScoreWithCoords {};
 
@@ -254,7 +256,7 @@ namespace Swipe {
 
 namespace BandedSwipe {
 
-DECL_DISPATCH(std::list<Hsp>, swipe, (const Sequence&query, std::vector<DpTarget> &targets8, const std::vector<DpTarget> &targets16, const std::vector<DpTarget>& targets32, DynamicIterator<DpTarget>* targets, Frame frame, const Bias_correction *composition_bias, int flags, Statistics &stat))
+DECL_DISPATCH(std::vector<Hsp>, swipe, (const Sequence&query, std::vector<DpTarget> &targets8, const std::vector<DpTarget> &targets16, const std::vector<DpTarget>& targets32, DynamicIterator<DpTarget>* targets, Frame frame, const Bias_correction *composition_bias, QueryProfiles* profiles, int flags, Statistics &stat))
 
 }
 
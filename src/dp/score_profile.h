@@ -21,10 +21,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 #include <vector>
+#include <array>
 #include "../basic/sequence.h"
 #include "score_vector.h"
 #include "../basic/value.h"
 #include "../stats/hauser_correction.h"
+#include "../stats/cbs.h"
+#include "../basic/config.h"
 
 struct LongScoreProfile
 {
@@ -67,3 +70,48 @@ struct LongScoreProfile
 	std::vector<int8_t> data[AMINO_ACID_COUNT];
 	enum { padding = 128 };
 };
+
+// Query data shared by the stages of the extension pipeline. It is built once per query and passed through the gapped
+// filter, the ungapped stage and the banded swipe; parts that are only needed by some modes are computed on first use.
+struct QueryProfiles
+{
+	QueryProfiles(const Sequence* query, const Bias_correction* query_cb, unsigned contexts) :
+		true_aa(Stats::count_true_aa(query[0])),
+		query_(query),
+		query_cb_(query_cb),
+		contexts_(contexts)
+	{}
+	// Per context profiles for the gapped filter, including the composition bias if Hauser correction is enabled.
+	const LongScoreProfile* long_profiles()
+	{
+		if (long_profiles_.empty()) {
+			long_profiles_.reserve(contexts_);
+			for (unsigned i = 0; i < contexts_; ++i)
+				if (Stats::CBS::hauser(config.comp_based_stats))
+					long_profiles_.emplace_back(query_[i], query_cb_[i]);
+				else
+					long_profiles_.emplace_back(query_[i]);
+		}
+		return long_profiles_.data();
+	}
+	Sequence reversed(unsigned context)
+	{
+		if (reversed_[context].empty() && query_[context].length() > 0)
+			reversed_[context] = query_[context].reverse();
+		return Sequence(reversed_[context]);
+	}
+	const Bias_correction& reversed_cb(unsigned context)
+	{
+		if (reversed_cb_[context].int8.empty())
+			reversed_cb_[context] = query_cb_[context].reverse();
+		return reversed_cb_[context];
+	}
+	const int true_aa;
+private:
+	const Sequence* query_;
+	const Bias_correction* query_cb_;
+	const unsigned contexts_;
+	std::vector<LongScoreProfile> long_profiles_;
+	std::array<std::vector<Letter>, MAX_CONTEXT> reversed_;
+	std::array<Bias_correction, MAX_CONTEXT> reversed_cb_;
+};
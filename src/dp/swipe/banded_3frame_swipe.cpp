@@ -21,10 +21,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <utility>
 #include <numeric>
 #include <atomic>
+#include <functional>
+#include <cmath>
 #include "../dp.h"
 #include "swipe.h"
 #include "target_iterator.h"
 #include "../../util/data_structures/mem_buffer.h"
+#include "../score_vector_int8.h"
 #include "../score_vector_int16.h"
 
 using std::list;
@@ -101,6 +104,131 @@ private:
 
 };
 
+// Walks the traceback over the scores of a 3-frame DP matrix, which are addressed by their offset in the full matrix
+// of band + 1 score vectors per column.
+template<typename _sv, typename _matrix>
+struct Banded3FrameTracebackIterator
+{
+	typedef typename ScoreTraits<_sv>::Score Score;
+	Banded3FrameTracebackIterator(_matrix &dp, ptrdiff_t pos, size_t band, int frame, int i, int j) :
+		dp_(dp),
+		band_(band),
+		pos_(pos),
+		frame(frame),
+		i(i),
+		j(j)
+	{
+		assert(i >= 0 && j >= 0);
+	}
+	Score score() const
+	{
+		return dp_.score(pos_);
+	}
+	Score sm3() const
+	{
+		return dp_.score(pos_ - (band_ + 1) * ScoreTraits<_sv>::CHANNELS);
+	}
+	Score sm4() const
+	{
+		return dp_.score(pos_ - (band_ + 2) * ScoreTraits<_sv>::CHANNELS);
+	}
+	Score sm2() const
+	{
+		return dp_.score(pos_ - band_ * ScoreTraits<_sv>::CHANNELS);
+	}
+	void walk_diagonal()
+	{
+		pos_ -= (band_ + 1) * ScoreTraits<_sv>::CHANNELS;
+		--i;
+		--j;
+		assert(i >= -1 && j >= -1);
+	}
+	void walk_forward_shift()
+	{
+		pos_ -= (band_ + 2) * ScoreTraits<_sv>::CHANNELS;
+		--i;
+		--j;
+		--frame;
+		if (frame == -1) {
+			frame = 2;
+			--i;
+		}
+		assert(i >= -1 && j >= -1);
+	}
+	void walk_reverse_shift()
+	{
+		pos_ -= band_ * ScoreTraits<_sv>::CHANNELS;
+		--i;
+		--j;
+		++frame;
+		if (frame == 3) {
+			frame = 0;
+			++i;
+		}
+		assert(i >= -1 && j >= -1);
+	}
+	pair<Edit_operation, int> walk_gap(int d0, int d1)
+	{
+		const int i0 = std::max(d0 + j, 0), j0 = std::max(i - d1, -1);
+		const ptrdiff_t h_step = (band_ - 2) * ScoreTraits<_sv>::CHANNELS, v_step = 3 * ScoreTraits<_sv>::CHANNELS,
+			h0 = pos_ - (j - j0) * h_step, v0 = pos_ - (i - i0 + 1) * v_step;
+		ptrdiff_t h = pos_ - h_step, v = pos_ - v_step;
+		const Score score = this->score();
+		const int e = score_matrix.gap_extend();
+		int g = score_matrix.gap_open() + e;
+		int l = 1;
+		while (v > v0 && h > h0) {
+			if (score + g == dp_.score(h)) {
+				walk_hgap(h, l);
+				return std::make_pair(op_deletion, l);
+			}
+			else if (score + g == dp_.score(v)) {
+				walk_vgap(v, l);
+				return std::make_pair(op_insertion, l);
+			}
+			h -= h_step;
+			v -= v_step;
+			++l;
+			g += e;
+		}
+		while (v > v0) {
+			if (score + g == dp_.score(v)) {
+				walk_vgap(v, l);
+				return std::make_pair(op_insertion, l);
+			}
+			v -= v_step;
+			++l;
+			g += e;
+		}
+		while (h > h0) {
+			if (score + g == dp_.score(h)) {
+				walk_hgap(h, l);
+				return std::make_pair(op_deletion, l);
+			}
+			h -= h_step;
+			++l;
+			g += e;
+		}
+		throw std::runtime_error("Traceback error.");
+	}
+	void walk_hgap(ptrdiff_t h, int l)
+	{
+		pos_ = h;
+		j -= l;
+		assert(i >= -1 && j >= -1);
+	}
+	void walk_vgap(ptrdiff_t v, int l)
+	{
+		pos_ = v;
+		i -= l;
+		assert(i >= -1 && j >= -1);
+	}
+	_matrix &dp_;
+	const ptrdiff_t band_;
+	ptrdiff_t pos_;
+	int frame, i, j;
+};
+
 template<typename _sv>
 struct Banded3FrameSwipeTracebackMatrix
 {
@@ -147,135 +275,24 @@ struct Banded3FrameSwipeTracebackMatrix
 		_sv sm4, sm3, sm2;
 	};
 
-	struct TracebackIterator
-	{
-		TracebackIterator(const Score *score, size_t band, int frame, int i, int j) :
-			band_(band),
-			score_(score),
-			frame(frame),
-			i(i),
-			j(j)
-		{
-			assert(i >= 0 && j >= 0);
-		}
-		Score score() const
-		{
-			return *score_;
-		}
-		Score sm3() const
-		{
-			return *(score_ - (band_ + 1) * ScoreTraits<_sv>::CHANNELS);
-		}
-		Score sm4() const
-		{
-			return *(score_ - (band_ + 2) * ScoreTraits<_sv>::CHANNELS);
-		}
-		Score sm2() const
-		{
-			return *(score_ - band_ * ScoreTraits<_sv>::CHANNELS);
-		}
-		void walk_diagonal()
-		{
-			score_ -= (band_ + 1) * ScoreTraits<_sv>::CHANNELS;
-			--i;
-			--j;
-			assert(i >= -1 && j >= -1);
-		}
-		void walk_forward_shift()
-		{
-			score_ -= (band_ + 2) * ScoreTraits<_sv>::CHANNELS;
-			--i;
-			--j;
-			--frame;
-			if (frame == -1) {
-				frame = 2;
-				--i;
-			}
-			assert(i >= -1 && j >= -1);
-		}
-		void walk_reverse_shift()
-		{
-			score_ -= band_ * ScoreTraits<_sv>::CHANNELS;
-			--i;
-			--j;
-			++frame;
-			if (frame == 3) {
-				frame = 0;
-				++i;
-			}
-			assert(i >= -1 && j >= -1);
-		}
-		pair<Edit_operation, int> walk_gap(int d0, int d1)
-		{
-			const int i0 = std::max(d0 + j, 0), j0 = std::max(i - d1, -1);
-			const Score *h = score_ - (band_ - 2) * ScoreTraits<_sv>::CHANNELS, *h0 = score_ - (j - j0) * (band_ - 2) * ScoreTraits<_sv>::CHANNELS;
-			const Score *v = score_ - 3 * ScoreTraits<_sv>::CHANNELS, *v0 = score_ - (i - i0 + 1) * 3 * ScoreTraits<_sv>::CHANNELS;
-			const Score score = this->score();
-			const Score e = score_matrix.gap_extend();
-			Score g = score_matrix.gap_open() + e;
-			int l = 1;
-			while (v > v0 && h > h0) {
-				if (score + g == *h) {
-					walk_hgap(h, l);
-					return std::make_pair(op_deletion, l);
-				}
-				else if (score + g == *v) {
-					walk_vgap(v, l);
-					return std::make_pair(op_insertion, l);
-				}
-				h -= (band_ - 2) * ScoreTraits<_sv>::CHANNELS;
-				v -= 3 * ScoreTraits<_sv>::CHANNELS;
-				++l;
-				g += e;
-			}
-			while (v > v0) {
-				if (score + g == *v) {
-					walk_vgap(v, l);
-					return std::make_pair(op_insertion, l);
-				}
-				v -= 3 * ScoreTraits<_sv>::CHANNELS;
-				++l;
-				g += e;
-			}
-			while (h > h0) {
-				if (score + g == *h) {
-					walk_hgap(h, l);
-					return std::make_pair(op_deletion, l);
-				}
-				h -= (band_ - 2) * ScoreTraits<_sv>::CHANNELS;
-				++l;
-				g += e;
-			}
-			throw std::runtime_error("Traceback error.");
-		}
-		void walk_hgap(const Score *h, int l)
-		{
-			score_ = h;
-			j -= l;
-			assert(i >= -1 && j >= -1);
-		}
-		void walk_vgap(const Score *v, int l)
-		{
-			score_ = v;
-			i -= l;
-			assert(i >= -1 && j >= -1);
-		}
-		const size_t band_;
-		const Score *score_;
-		int frame, i, j;
-	};
+	typedef Banded3FrameTracebackIterator<_sv, Banded3FrameSwipeTracebackMatrix> TracebackIterator;
 
-	TracebackIterator traceback(size_t col, int i0, int j, int dna_len, size_t channel, Score score) const
+	TracebackIterator traceback(size_t col, int i0, int j, int dna_len, size_t channel, Score score)
 	{
 		const int i_ = std::max(-i0, 0) * 3,
 			i1 = (int)std::min(band_, size_t(dna_len - 2 - i0 * 3));
-		const Score *s = (Score*)(&score_[col*(band_ + 1) + i_]) + channel;
-		for (int i = i_; i < i1; ++i, s += ScoreTraits<_sv>::CHANNELS)
-			if (*s == score)
-				return TracebackIterator(s, band_, i % 3, i0 + i / 3, j);
+		ptrdiff_t pos = ptrdiff_t(col*(band_ + 1) + i_) * ScoreTraits<_sv>::CHANNELS + channel;
+		for (int i = i_; i < i1; ++i, pos += ScoreTraits<_sv>::CHANNELS)
+			if (this->score(pos) == score)
+				return TracebackIterator(*this, pos, band_, i % 3, i0 + i / 3, j);
 		throw std::runtime_error("Trackback error.");
 	}
 
+	Score score(ptrdiff_t pos) const
+	{
+		return ((const Score*)score_.begin())[pos];
+	}
+
 	Banded3FrameSwipeTracebackMatrix(size_t band, size_t cols) :
 		band_(band)
 	{
@@ -309,6 +326,146 @@ template<typename _sv> thread_local MemBuffer<_sv> Banded3FrameSwipeMatrix<_sv>:
 template<typename _sv> thread_local MemBuffer<_sv> Banded3FrameSwipeMatrix<_sv>::score_;
 template<typename _sv> thread_local MemBuffer<_sv> Banded3FrameSwipeTracebackMatrix<_sv>::hgap_;
 
+// Traceback matrix for large DP problems. The forward pass runs on a single column like the score-only matrix and keeps
+// the score and horizontal gap columns at every interval_-th column. The score columns of a segment are recomputed from
+// its checkpoint when the traceback reaches them. Two segments are cached, so that a gap walk can look back into the
+// previous segment while the current column stays loaded.
+template<typename _sv>
+struct Banded3FrameSwipeCheckpointMatrix
+{
+
+	typedef typename ScoreTraits<_sv>::Score Score;
+	typedef typename Banded3FrameSwipeMatrix<_sv>::ColumnIterator ColumnIterator;
+	typedef typename Banded3FrameSwipeTracebackMatrix<_sv>::ColumnIterator ReplayIterator;
+	typedef Banded3FrameTracebackIterator<_sv, Banded3FrameSwipeCheckpointMatrix> TracebackIterator;
+	typedef ::DISPATCH_ARCH::TargetIterator<Score> Targets;
+	typedef std::function<void(int, int, Targets&)> Replay;
+
+	struct Checkpoint {
+		Checkpoint(const Targets& targets) :
+			targets(targets)
+		{}
+		Targets targets;
+		std::vector<_sv> hgap, score;
+	};
+
+	struct Segment {
+		Segment() :
+			id(-1)
+		{}
+		int id;
+		MemBuffer<_sv> score;
+	};
+
+	Banded3FrameSwipeCheckpointMatrix(size_t band, size_t cols) :
+		band_(band),
+		interval_(std::max((int)std::sqrt((double)cols), 1)),
+		cols_(0),
+		last_(0),
+		loading_(nullptr)
+	{
+		hgap_.resize(band + 3);
+		score_.resize(band + 1);
+		std::fill(hgap_.begin(), hgap_.end(), _sv());
+		std::fill(score_.begin(), score_.end(), _sv());
+	}
+
+	void save(int col, const Targets& targets)
+	{
+		cols_ = col + 1;
+		if (col % interval_ != 0)
+			return;
+		checkpoints_.emplace_back(targets);
+		checkpoints_.back().hgap.assign(hgap_.begin(), hgap_.end());
+		checkpoints_.back().score.assign(score_.begin(), score_.end());
+	}
+
+	inline ColumnIterator begin(size_t offset, size_t col)
+	{
+		return ColumnIterator(&hgap_[offset], &score_[offset]);
+	}
+
+	// column col of a segment replay, whose first column holds the scores of its checkpoint
+	inline ReplayIterator replay_begin(size_t offset, size_t col)
+	{
+		_sv* s = loading_->score.begin() + (col - size_t(loading_->id) * interval_) * (band_ + 1) + offset;
+		return ReplayIterator(&hgap_[offset], s, s + band_ + 1);
+	}
+
+	size_t band() const
+	{
+		return band_;
+	}
+
+	TracebackIterator traceback(size_t col, int i0, int j, int dna_len, size_t channel, Score score)
+	{
+		const int i_ = std::max(-i0, 0) * 3,
+			i1 = (int)std::min(band_, size_t(dna_len - 2 - i0 * 3));
+		ptrdiff_t pos = ptrdiff_t(col*(band_ + 1) + i_) * ScoreTraits<_sv>::CHANNELS + channel;
+		for (int i = i_; i < i1; ++i, pos += ScoreTraits<_sv>::CHANNELS)
+			if (this->score(pos) == score)
+				return TracebackIterator(*this, pos, band_, i % 3, i0 + i / 3, j);
+		throw std::runtime_error("Trackback error.");
+	}
+
+	// the matrix column col >= 1 is written by DP column col - 1, column 0 is the zero column of the first checkpoint
+	Score score(ptrdiff_t pos)
+	{
+		const ptrdiff_t col = pos / (ptrdiff_t(band_ + 1) * ScoreTraits<_sv>::CHANNELS);
+		const int id = col == 0 ? 0 : int((col - 1) / interval_);
+		Segment* seg = &segments_[last_];
+		if (seg->id != id) {
+			last_ ^= 1;
+			seg = &segments_[last_];
+			if (seg->id != id)
+				load_segment(*seg, id);
+		}
+		return ((const Score*)seg->score.begin())[pos - ptrdiff_t(id) * interval_ * ptrdiff_t(band_ + 1) * ScoreTraits<_sv>::CHANNELS];
+	}
+
+	Replay replay;
+
+private:
+
+	void load_segment(Segment& seg, int id)
+	{
+		const Checkpoint& c = checkpoints_[id];
+		const int j_begin = id * interval_, j_end = std::min(j_begin + interval_, cols_);
+		seg.id = id;
+		seg.score.resize(size_t(interval_ + 1) * (band_ + 1));
+		std::fill(seg.score.begin(), seg.score.end(), _sv());
+		std::copy(c.score.begin(), c.score.end(), seg.score.begin());
+		std::copy(c.hgap.begin(), c.hgap.end(), hgap_.begin());
+		Targets targets(c.targets);
+		loading_ = &seg;
+		replay(j_begin, j_end, targets);
+	}
+
+	const size_t band_;
+	const int interval_;
+	int cols_, last_;
+	MemBuffer<_sv> hgap_, score_;
+	Segment segments_[2], *loading_;
+	std::vector<Checkpoint> checkpoints_;
+
+};
+
+template<typename _matrix, typename _targets>
+void save_checkpoint(_matrix&, int, const _targets&) {}
+
+template<typename _sv, typename _targets>
+void save_checkpoint(Banded3FrameSwipeCheckpointMatrix<_sv>& dp, int col, const _targets& targets) {
+	dp.save(col, targets);
+}
+
+template<typename _matrix, typename _f>
+void set_replay(_matrix&, _f&) {}
+
+template<typename _sv, typename _f>
+void set_replay(Banded3FrameSwipeCheckpointMatrix<_sv>& dp, _f& f) {
+	dp.replay = [&dp, &f](int j_begin, int j_end, typename Banded3FrameSwipeCheckpointMatrix<_sv>::Targets& targets) { f(dp, j_begin, j_end, targets); };
+}
+
 template<typename _sv, typename _traceback>
 struct Banded3FrameSwipeMatrixRef
 {
@@ -326,12 +483,25 @@ struct Banded3FrameSwipeMatrixRef<_sv, DP::ScoreOnly>
 	typedef Banded3FrameSwipeMatrix<_sv> type;
 };
 
+// Only the 32 bit kernel, which aligns one target per call, supports checkpointing.
 template<typename _sv>
-Hsp traceback(Sequence *query, Strand strand, int dna_len, const Banded3FrameSwipeTracebackMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1)
+struct Banded3FrameSwipeMatrixRef<_sv, DP::CheckpointTraceback>
+{
+	typedef Banded3FrameSwipeTracebackMatrix<_sv> type;
+};
+
+template<>
+struct Banded3FrameSwipeMatrixRef<int32_t, DP::CheckpointTraceback>
+{
+	typedef Banded3FrameSwipeCheckpointMatrix<int32_t> type;
+};
+
+template<typename _sv, typename _matrix>
+Hsp matrix_traceback(Sequence *query, Strand strand, int dna_len, _matrix &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1)
 {
 	typedef typename ScoreTraits<_sv>::Score Score;
 	const int j0 = i1 - (target.d_end - 1), d1 = target.d_end;
-	typename Banded3FrameSwipeTracebackMatrix<_sv>::TracebackIterator it(dp.traceback(max_col + 1, i0 + max_col, j0 + max_col, dna_len, channel, max_score));
+	typename _matrix::TracebackIterator it(dp.traceback(max_col + 1, i0 + max_col, j0 + max_col, dna_len, channel, max_score));
 	
 	Hsp out;
 	out.swipe_target = target.target_idx;
@@ -370,12 +540,26 @@ Hsp traceback(Sequence *query, Strand strand, int dna_len, const Banded3FrameSwi
 	return out;
 }
 
+template<typename _sv>
+Hsp traceback(Sequence *query, Strand strand, int dna_len, Banded3FrameSwipeTracebackMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1)
+{
+	return matrix_traceback<_sv>(query, strand, dna_len, dp, target, d_begin, max_score, evalue, max_col, channel, i0, i1);
+}
+
+template<typename _sv>
+Hsp traceback(Sequence *query, Strand strand, int dna_len, Banded3FrameSwipeCheckpointMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1)
+{
+	return matrix_traceback<_sv>(query, strand, dna_len, dp, target, d_begin, max_score, evalue, max_col, channel, i0, i1);
+}
+
 template<typename _sv>
 Hsp traceback(Sequence *query, Strand strand, int dna_len, const Banded3FrameSwipeMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1)
 {
 	Hsp out;
 	const int j0 = i1 - (target.d_end - 1);
 	out.swipe_target = target.target_idx;
+	out.d_begin = target.d_begin;
+	out.d_end = target.d_end;
 	out.score = ScoreTraits<_sv>::int_score(max_score) * config.cbs_matrix_scale;
 	out.evalue = evalue;
 	out.query_range.end_ = std::min(i0 + max_col + (int)dp.band() / 3 / 2, (int)query[0].length());
@@ -429,14 +613,7 @@ list<Hsp> banded_3frame_swipe(
 		max_col[i] = 0;
 	}
 
-	int j = 0;
-	while (targets.active.size() > 0) {
-		const int i0_ = std::max(i0, 0), i1_ = std::min(i1, qlen - 1);
-		if (i0_ > i1_)
-			break;
-		typename Matrix::ColumnIterator it(dp.begin((i0_ - i0) * 3, j));
-		if (i0_ - i0 > 0)
-			it.set_zero();
+	auto dp_column = [&](auto it, const TargetIterator<Score>& targets, int i0_, int i1_) {
 		_sv vgap0, vgap1, vgap2, hgap, col_best;
 		vgap0 = vgap1 = vgap2 = col_best = ScoreTraits<_sv>::zero();
 
@@ -464,6 +641,36 @@ list<Hsp> banded_3frame_swipe(
 			it.set_score(next);
 			++it;
 		}
+		return col_best;
+	};
+
+	const int i0_begin = i0, i1_begin = i1;
+	auto replay = [&](auto& dp, int j_begin, int j_end, TargetIterator<Score>& targets) {
+		for (int j = j_begin; j < j_end; ++j) {
+			const int i0 = i0_begin + j, i0_ = std::max(i0, 0), i1_ = std::min(i1_begin + j, qlen - 1);
+			auto it = dp.replay_begin((i0_ - i0) * 3, j);
+			if (i0_ - i0 > 0)
+				it.set_zero();
+			dp_column(it, targets, i0_, i1_);
+			for (int i = 0; i < targets.active.size();)
+				if (!targets.inc(targets.active[i]))
+					targets.active.erase(i);
+				else
+					++i;
+		}
+	};
+	set_replay(dp, replay);
+
+	int j = 0;
+	while (targets.active.size() > 0) {
+		const int i0_ = std::max(i0, 0), i1_ = std::min(i1, qlen - 1);
+		if (i0_ > i1_)
+			break;
+		save_checkpoint(dp, j, targets);
+		typename Matrix::ColumnIterator it(dp.begin((i0_ - i0) * 3, j));
+		if (i0_ - i0 > 0)
+			it.set_zero();
+		const _sv col_best = dp_column(it, targets, i0_, i1_);
 
 #ifdef DP_STAT
 		//stat.net_cells += targets.live * (i1_ - i0_ + 1) * 3;
@@ -516,12 +723,33 @@ list<Hsp> banded_3frame_swipe_targets(vector<DpTarget>::const_iterator begin,
 	for (vector<DpTarget>::const_iterator i = begin; i < end; i += std::min((ptrdiff_t)ScoreTraits<_sv>::CHANNELS, end - i)) {
 		if (score_only)
 			out.splice(out.end(), banded_3frame_swipe<_sv, DP::ScoreOnly>(query, strand, i, i + std::min(ptrdiff_t(ScoreTraits<_sv>::CHANNELS), end - i), stat, parallel, overflow));
+		else if (ScoreTraits<_sv>::CHANNELS == 1 && size_t(i->d_end - i->d_begin) * i->seq.length() > config.traceback_checkpoint_dp)
+			out.splice(out.end(), banded_3frame_swipe<_sv, DP::CheckpointTraceback>(query, strand, i, i + 1, stat, parallel, overflow));
 		else
 			out.splice(out.end(), banded_3frame_swipe<_sv, DP::Traceback>(query, strand, i, i + std::min(ptrdiff_t(ScoreTraits<_sv>::CHANNELS), end - i), stat, parallel, overflow));
 	}
 	return out;
 }
 
+static list<Hsp> banded_3frame_swipe_first_pass(vector<DpTarget>::const_iterator begin,
+	vector<DpTarget>::const_iterator end,
+	bool score_only,
+	const TranslatedSequence &query,
+	Strand strand,
+	DpStat &stat,
+	bool parallel,
+	vector<DpTarget> &overflow)
+{
+#ifdef __SSE4_1__
+	if (score_only)
+		return banded_3frame_swipe_targets<score_vector<int8_t>>(begin, end, score_only, query, strand, stat, parallel, overflow);
+#elif defined(__SSE2__)
+	if (score_only)
+		return banded_3frame_swipe_targets<score_vector<int16_t>>(begin, end, score_only, query, strand, stat, parallel, overflow);
+#endif
+	return banded_3frame_swipe_targets<int32_t>(begin, end, score_only, query, strand, stat, parallel, overflow);
+}
+
 void banded_3frame_swipe_worker(vector<DpTarget>::const_iterator begin,
 	vector<DpTarget>::const_iterator end,
 	atomic<size_t> *next,
@@ -535,20 +763,18 @@ void banded_3frame_swipe_worker(vector<DpTarget>::const_iterator begin,
 	size_t pos;
 	vector<DpTarget> of;
 	while (begin + (pos = next->fetch_add(config.swipe_chunk_size)) < end)
-#ifdef __SSE2__
-		if(score_only)
-			out->splice(out->end(), banded_3frame_swipe_targets<score_vector<int16_t>>(begin + pos, min(begin + pos + config.swipe_chunk_size, end), score_only, *query, strand, stat, true, of));
-		else
-			out->splice(out->end(), banded_3frame_swipe_targets<int32_t>(begin + pos, min(begin + pos + config.swipe_chunk_size, end), score_only, *query, strand, stat, true, of));
-#else
-		out->splice(out->end(), banded_3frame_swipe_targets<int32_t>(begin + pos, min(begin + pos + config.swipe_chunk_size, end), score_only, *query, strand, stat, true, of));
-#endif
+		out->splice(out->end(), banded_3frame_swipe_first_pass(begin + pos, min(begin + pos + config.swipe_chunk_size, end), score_only, *query, strand, stat, true, of));
 	*overflow = std::move(of);
 }
 
 list<Hsp> banded_3frame_swipe(const TranslatedSequence &query, Strand strand, vector<DpTarget>::iterator target_begin, vector<DpTarget>::iterator target_end, DpStat &stat, bool score_only, bool parallel)
 {
-	vector<DpTarget> overflow16, overflow32;
+	vector<DpTarget> overflow8, overflow16, overflow32;
+#ifdef __SSE4_1__
+	vector<DpTarget> &overflow = overflow8;
+#else
+	vector<DpTarget> &overflow = overflow16;
+#endif
 #ifdef __SSE2__
 	task_timer timer("Banded 3frame swipe (sort)", parallel ? 3 : UINT_MAX);
 	std::stable_sort(target_begin, target_end);
@@ -578,17 +804,16 @@ list<Hsp> banded_3frame_swipe(const TranslatedSequence &query, Strand strand, ve
 			out.splice(out.end(), *l);
 			delete l;
 		}
-		overflow16.reserve(std::accumulate(thread_overflow.begin(), thread_overflow.end(), (size_t)0, [](size_t n, const vector<DpTarget> &v) { return n + v.size(); }));
+		overflow.reserve(std::accumulate(thread_overflow.begin(), thread_overflow.end(), (size_t)0, [](size_t n, const vector<DpTarget> &v) { return n + v.size(); }));
 		for (const vector<DpTarget> &v : thread_overflow)
-			overflow16.insert(overflow16.end(), v.begin(), v.end());
-	}
-	else {
-		if(score_only)
-			out = banded_3frame_swipe_targets<score_vector<int16_t>>(target_begin, target_end, score_only, query, strand, stat, false, overflow16);
-		else
-			out = banded_3frame_swipe_targets<int32_t>(target_begin, target_end, score_only, query, strand, stat, false, overflow16);
+			overflow.insert(overflow.end(), v.begin(), v.end());
 	}
+	else
+		out = banded_3frame_swipe_first_pass(target_begin, target_end, score_only, query, strand, stat, false, overflow);
 
+#ifdef __SSE4_1__
+	out.splice(out.end(), banded_3frame_swipe_targets<score_vector<int16_t>>(overflow8.begin(), overflow8.end(), score_only, query, strand, stat, false, overflow16));
+#endif
 	out.splice(out.end(), banded_3frame_swipe_targets<int32_t>(overflow16.begin(), overflow16.end(), score_only, query, strand, stat, false, overflow32));
 	return out;
 #else
@@ -596,4 +821,4 @@ list<Hsp> banded_3frame_swipe(const TranslatedSequence &query, Strand strand, ve
 #endif
 }
 
-}
\ No newline at end of file
+}
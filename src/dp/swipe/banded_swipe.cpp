@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <array>
 #include <algorithm>
 #include <utility>
-#include <list>
+#include <iterator>
+#include <functional>
+#include <cmath>
 #include <limits.h>
 #include "../dp.h"
 #include "swipe.h"
@@ -34,7 +36,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../util/intrin.h"
 #include "../../util/memory/alignment.h"
 
-using std::list;
 using std::pair;
 using std::vector;
 using std::array;
@@ -497,6 +498,161 @@ template<typename _sv> thread_local MemBuffer<TraceStat<_sv>> TracebackStatMatri
 template<typename _sv> thread_local MemBuffer<TraceStat<_sv>> TracebackStatMatrix<_sv>::hstat_;
 #endif
 
+// Traceback matrix for large DP problems. The forward pass only keeps the score and horizontal gap columns at every
+// interval_-th column. The trace masks are recomputed one segment of columns at a time when the traceback reaches them,
+// so memory grows with band * sqrt(columns) instead of band * columns.
+template<typename _sv>
+struct TracebackCheckpointMatrix
+{
+	typedef typename ScoreTraits<_sv>::TraceMask TraceMask;
+	typedef void* Stat;
+	typedef typename TracebackVectorMatrix<_sv>::ColumnIterator ColumnIterator;
+	typedef ::DISPATCH_ARCH::TargetIterator<typename ScoreTraits<_sv>::Score> Targets;
+	typedef std::function<void(int, int, Targets&)> Replay;
+
+	struct Checkpoint {
+		Checkpoint(const Targets& targets):
+			targets(targets)
+		{}
+		Targets targets;
+		std::vector<_sv> hgap, score;
+	};
+
+	struct TracebackIterator
+	{
+		TracebackIterator(TracebackCheckpointMatrix& dp, ptrdiff_t pos, int i, int j, size_t channel) :
+			dp_(dp),
+			pos_(pos),
+			channel_mask_vgap(TraceMask::vmask(channel)),
+			channel_mask_hgap(TraceMask::hmask(channel)),
+			i(i),
+			j(j)
+		{
+			assert(i >= 0 && j >= 0);
+		}
+		TraceMask mask() const {
+			return dp_.mask(pos_);
+		}
+		void walk_diagonal()
+		{
+			pos_ -= dp_.band_;
+			--i;
+			--j;
+			assert(i >= -1 && j >= -1);
+		}
+		pair<Edit_operation, int> walk_gap()
+		{
+			if (mask().gap & channel_mask_vgap) {
+				int l = 0;
+				do {
+					++l;
+					--i;
+					--pos_;
+				} while (((mask().open & channel_mask_vgap) == 0) && (i > 0));
+				return std::make_pair(op_insertion, l);
+			}
+			else {
+				int l = 0;
+				do {
+					++l;
+					--j;
+					pos_ -= dp_.band_ - 1;
+				} while (((mask().open & channel_mask_hgap) == 0) && (j > 0));
+				return std::make_pair(op_deletion, l);
+			}
+		}
+		TracebackCheckpointMatrix& dp_;
+		ptrdiff_t pos_;
+		const decltype(TraceMask::gap) channel_mask_vgap, channel_mask_hgap;
+		int i, j;
+	};
+
+	TracebackIterator traceback(size_t col, int i0, int band_i, int j, int query_len, size_t channel)
+	{
+		return TracebackIterator(*this, ptrdiff_t(col * band_ + band_i), i0 + band_i, j, channel);
+	}
+
+	TracebackCheckpointMatrix(int band, size_t cols) :
+		band_(band),
+		interval_(std::max((int)std::sqrt(double(cols) * 2 * sizeof(_sv) / sizeof(TraceMask)), 1)),
+		cols_(0),
+		seg_begin_(-1),
+		seg_end_(-1)
+	{
+		hgap_.resize(band + 1);
+		score_.resize(band);
+		scratch_.resize(band);
+		std::fill(hgap_.begin(), hgap_.end(), _sv());
+		std::fill(score_.begin(), score_.end(), _sv());
+	}
+
+	void save(int col, const Targets& targets) {
+		cols_ = col + 1;
+		if (col % interval_ != 0)
+			return;
+		checkpoints_.emplace_back(targets);
+		checkpoints_.back().hgap.assign(hgap_.begin(), hgap_.end());
+		checkpoints_.back().score.assign(score_.begin(), score_.end());
+	}
+
+	inline ColumnIterator begin(int offset, int col)
+	{
+		TraceMask* mask = seg_begin_ >= 0 ? &trace_mask_[size_t(col - seg_begin_ + 1) * (size_t)band_ + (size_t)offset] : &scratch_[offset];
+		return ColumnIterator(&hgap_[offset], &score_[offset], mask);
+	}
+
+	int band() const {
+		return band_;
+	}
+
+	TraceMask mask(ptrdiff_t pos) {
+		const int col = int(pos / band_) - 1;
+		if (col < 0)
+			return TraceMask();
+		if (col < seg_begin_ || col >= seg_end_)
+			load_segment(col / interval_);
+		return trace_mask_[size_t(col - seg_begin_ + 1) * (size_t)band_ + size_t(pos % band_)];
+	}
+
+	Replay replay;
+
+private:
+
+	void load_segment(int segment) {
+		Checkpoint& c = checkpoints_[segment];
+		std::copy(c.hgap.begin(), c.hgap.end(), hgap_.begin());
+		std::copy(c.score.begin(), c.score.end(), score_.begin());
+		seg_begin_ = segment * interval_;
+		seg_end_ = std::min(seg_begin_ + interval_, cols_);
+		trace_mask_.resize(size_t(seg_end_ - seg_begin_ + 1) * band_);
+		Targets targets(c.targets);
+		replay(seg_begin_, seg_end_, targets);
+	}
+
+	const int band_, interval_;
+	int cols_, seg_begin_, seg_end_;
+	MemBuffer<_sv> hgap_, score_;
+	MemBuffer<TraceMask> scratch_, trace_mask_;
+	std::vector<Checkpoint> checkpoints_;
+
+};
+
+template<typename _matrix, typename _targets>
+void save_checkpoint(_matrix&, int, const _targets&) {}
+
+template<typename _sv, typename _targets>
+void save_checkpoint(TracebackCheckpointMatrix<_sv>& dp, int col, const _targets& targets) {
+	dp.save(col, targets);
+}
+
+template<typename _matrix, typename _f>
+void set_replay(_matrix&, _f&) {}
+
+template<typename _sv, typename _f>
+void set_replay(TracebackCheckpointMatrix<_sv>& dp, _f& f) {
+	dp.replay = [&dp, &f](int j_begin, int j_end, typename TracebackCheckpointMatrix<_sv>::Targets& targets) { f(dp, j_begin, j_end, targets); };
+}
+
 template<typename _sv, typename _traceback>
 struct MatrixTraits
 {};
@@ -522,6 +678,13 @@ struct MatrixTraits<_sv, VectorTraceback>
 	typedef RowCounter<_sv> MyRowCounter;
 };
 
+template<typename _sv>
+struct MatrixTraits<_sv, CheckpointTraceback>
+{
+	typedef TracebackCheckpointMatrix<_sv> Type;
+	typedef RowCounter<_sv> MyRowCounter;
+};
+
 template<typename _sv>
 struct MatrixTraits<_sv, ScoreOnly>
 {
@@ -609,14 +772,14 @@ Hsp traceback(const Sequence &query, Frame frame, _cbs bias_correction, const Tr
 	return out;
 }
 
-template<typename _sv, typename _cbs>
-Hsp traceback(const Sequence &query, Frame frame, _cbs bias_correction, const TracebackVectorMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1, int max_band_i)
+template<typename _sv, typename _cbs, typename _matrix>
+Hsp vector_traceback(const Sequence &query, Frame frame, _cbs bias_correction, _matrix &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1, int max_band_i)
 {
 	typedef typename ScoreTraits<_sv>::Score Score;
 	typedef typename ScoreTraits<_sv>::TraceMask TraceMask;
 	const auto channel_mask = TraceMask::vmask(channel) | TraceMask::hmask(channel);
-	const int j0 = i1 - (target.d_end - 1), d1 = target.d_end;
-	typename TracebackVectorMatrix<_sv>::TracebackIterator it(dp.traceback(max_col + 1, i0 + max_col, max_band_i, j0 + max_col, (int)query.length(), channel));
+	const int j0 = i1 - (target.d_end - 1);
+	typename _matrix::TracebackIterator it(dp.traceback(max_col + 1, i0 + max_col, max_band_i, j0 + max_col, (int)query.length(), channel));
 	Hsp out;
 	out.swipe_target = target.target_idx;
 	out.score = ScoreTraits<_sv>::int_score(max_score);
@@ -659,6 +822,18 @@ Hsp traceback(const Sequence &query, Frame frame, _cbs bias_correction, const Tr
 	return out;
 }
 
+template<typename _sv, typename _cbs>
+Hsp traceback(const Sequence &query, Frame frame, _cbs bias_correction, const TracebackVectorMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1, int max_band_i)
+{
+	return vector_traceback<_sv>(query, frame, bias_correction, dp, target, d_begin, max_score, evalue, max_col, channel, i0, i1, max_band_i);
+}
+
+template<typename _sv, typename _cbs>
+Hsp traceback(const Sequence &query, Frame frame, _cbs bias_correction, TracebackCheckpointMatrix<_sv> &dp, const DpTarget &target, int d_begin, typename ScoreTraits<_sv>::Score max_score, double evalue, int max_col, int channel, int i0, int i1, int max_band_i)
+{
+	return vector_traceback<_sv>(query, frame, bias_correction, dp, target, d_begin, max_score, evalue, max_col, channel, i0, i1, max_band_i);
+}
+
 template<typename _traceback>
 bool realign(const Hsp &hsp, const DpTarget &dp_target) {
 	return false;
@@ -674,8 +849,13 @@ bool realign<VectorTraceback>(const Hsp &hsp, const DpTarget &dp_target) {
 	return hsp.subject_range.begin_ - config.min_realign_overhang > dp_target.j_begin || hsp.subject_range.end_ + config.min_realign_overhang < dp_target.j_end;
 }
 
+template<>
+bool realign<CheckpointTraceback>(const Hsp &hsp, const DpTarget &dp_target) {
+	return realign<VectorTraceback>(hsp, dp_target);
+}
+
 template<typename _sv, typename _traceback, typename _cbs>
-list<Hsp> swipe(
+vector<Hsp> swipe(
 	const Sequence &query,
 	Frame frame,
 	vector<DpTarget>::const_iterator subject_begin,
@@ -734,18 +914,10 @@ list<Hsp> swipe(
 	std::fill(max_band_row, max_band_row + CHANNELS, 0);
 	CBSBuffer<_sv, _cbs> cbs_buf(composition_bias, qlen, cbs_mask);
 
-	int j = 0;
-	while (targets.active.size() > 0) {
-		const int i0_ = std::max(i0, 0), i1_ = std::min(i1, qlen - 1) + 1, band_offset = i0_ - i0;
-		if (i0_ >= i1_)
-			break;
-		typename Matrix::ColumnIterator it(dp.begin(band_offset, j));
+	typedef typename MatrixTraits<_sv, _traceback>::MyRowCounter MyRowCounter;
+	auto dp_column = [&](auto it, const ::DISPATCH_ARCH::TargetIterator<Score>& targets, int i0, int i0_, int i1_, MyRowCounter& row_counter) {
 		_sv vgap = _sv(), hgap = _sv(), col_best = _sv();
 		Stat stat_v = Stat();
-		typename MatrixTraits<_sv, _traceback>::MyRowCounter row_counter(band_offset);
-
-		if (band_offset > 0)
-			it.set_zero();
 
 		if (cbs_mask != 0) {
 			if (targets.custom_matrix_16bit)
@@ -789,6 +961,40 @@ list<Hsp> swipe(
 #ifdef STRICT_BAND
 		}
 #endif
+		return col_best;
+	};
+
+	const int i0_begin = i0, i1_begin = i1;
+	auto replay = [&](auto& dp, int j_begin, int j_end, ::DISPATCH_ARCH::TargetIterator<Score>& targets) {
+		for (int j = j_begin; j < j_end; ++j) {
+			const int i0 = i0_begin + j, i0_ = std::max(i0, 0), i1_ = std::min(i1_begin + j, qlen - 1) + 1, band_offset = i0_ - i0;
+			auto it = dp.begin(band_offset, j);
+			MyRowCounter row_counter(band_offset);
+			if (band_offset > 0)
+				it.set_zero();
+			dp_column(it, targets, i0, i0_, i1_, row_counter);
+			for (int i = 0; i < targets.active.size();)
+				if (!targets.inc(targets.active[i]))
+					targets.active.erase(i);
+				else
+					++i;
+		}
+	};
+	set_replay(dp, replay);
+
+	int j = 0;
+	while (targets.active.size() > 0) {
+		const int i0_ = std::max(i0, 0), i1_ = std::min(i1, qlen - 1) + 1, band_offset = i0_ - i0;
+		if (i0_ >= i1_)
+			break;
+		save_checkpoint(dp, j, targets);
+		typename Matrix::ColumnIterator it(dp.begin(band_offset, j));
+		MyRowCounter row_counter(band_offset);
+
+		if (band_offset > 0)
+			it.set_zero();
+
+		const _sv col_best = dp_column(it, targets, i0, i0_, i1_, row_counter);
 
 		Score col_best_[CHANNELS], i_max[CHANNELS];
 		store_sv(col_best, col_best_);
@@ -810,7 +1016,7 @@ list<Hsp> swipe(
 		++j;
 	}
 
-	list<Hsp> out;
+	vector<Hsp> out;
 	int realign = 0;
 	task_timer timer;
 	for (int i = 0; i < targets.n_targets; ++i) {
@@ -846,43 +1052,46 @@ list<Hsp> swipe(
 					realign_targets.back().seq.mask(hsp.subject_range);
 		}
 		vector<DpTarget> overflow;
-		out.splice(out.end(), swipe<_sv, _traceback>(query, frame, realign_targets.begin(), realign_targets.end(), composition_bias, overflow, stat));
+		vector<Hsp> v = swipe<_sv, _traceback>(query, frame, realign_targets.begin(), realign_targets.end(), composition_bias, overflow, stat);
+		out.insert(out.end(), std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
 	}
 	return out;
 }
 
 #ifdef __SSE4_1__
-template list<Hsp> swipe<score_vector<int8_t>, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<score_vector<int8_t>, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int8_t>, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int8_t>, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<score_vector<int8_t>, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
 #endif
 #ifdef __SSE2__
-template list<Hsp> swipe<score_vector<int16_t>, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<score_vector<int16_t>, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int16_t>, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int16_t>, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<score_vector<int16_t>, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
 #endif
-template list<Hsp> swipe<int32_t, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<int32_t, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<int32_t, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<int32_t, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, Traceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<int32_t, StatTraceback, const int8_t*>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, VectorTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, CheckpointTraceback, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, ScoreOnly, const int8_t*>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, const int8_t*, vector<DpTarget>&, Statistics&);
 
 #ifdef __SSE4_1__
-template list<Hsp> swipe<score_vector<int8_t>, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<score_vector<int8_t>, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int8_t>, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int8_t>, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<score_vector<int8_t>, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int8_t>, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
 #endif
 #ifdef __SSE2__
-template list<Hsp> swipe<score_vector<int16_t>, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<score_vector<int16_t>, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int16_t>, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<score_vector<int16_t>, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<score_vector<int16_t>, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<score_vector<int16_t>, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
 #endif
-template list<Hsp> swipe<int32_t, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-//template list<Hsp> swipe<int32_t, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<int32_t, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
-template list<Hsp> swipe<int32_t, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, Traceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+//template vector<Hsp> swipe<int32_t, StatTraceback, NoCBS>(const sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, int, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, VectorTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, CheckpointTraceback, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
+template vector<Hsp> swipe<int32_t, ScoreOnly, NoCBS>(const Sequence&, Frame, vector<DpTarget>::const_iterator, vector<DpTarget>::const_iterator, NoCBS, vector<DpTarget>&, Statistics&);
 
 }}}
\ No newline at end of file
@@ -19,8 +19,8 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
-#include <list>
 #include <atomic>
+#include <iterator>
 #include <thread>
 #include <numeric>
 #include <limits.h>
@@ -31,7 +31,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../util/dynamic_iterator.h"
 #include "../../data/sequence_set.h"
 
-using std::list;
 using std::atomic;
 using std::thread;
 using std::array;
@@ -39,14 +38,21 @@ using std::array;
 namespace DP { namespace Swipe { namespace DISPATCH_ARCH {
 
 template<typename _sv, typename _traceback, typename _cbs>
-list<Hsp> swipe(const Sequence& query, Frame frame, DynamicIterator<DpTarget>& targets, _cbs composition_bias, vector<DpTarget>& overflow, Statistics& stats);
+vector<Hsp> swipe(const Sequence& query, Frame frame, DynamicIterator<DpTarget>& targets, _cbs composition_bias, vector<DpTarget>& overflow, Statistics& stats);
 
 }}}
 
 namespace DP { namespace BandedSwipe { namespace DISPATCH_ARCH {
 
+static void append(vector<Hsp>& out, vector<Hsp>&& v) {
+	if (out.empty())
+		out = std::move(v);
+	else
+		out.insert(out.end(), std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+}
+
 template<typename _sv, typename _traceback, typename _cbs>
-list<Hsp> swipe(
+vector<Hsp> swipe(
 	const Sequence&query,
 	Frame frame,
 	vector<DpTarget>::const_iterator subject_begin,
@@ -56,7 +62,7 @@ list<Hsp> swipe(
 	Statistics &stat);
 
 template<typename _sv, typename _traceback>
-list<Hsp> swipe_dispatch_cbs(
+vector<Hsp> swipe_dispatch_cbs(
 	const Sequence&query,
 	Frame frame,
 	vector<DpTarget>::const_iterator subject_begin,
@@ -72,7 +78,7 @@ list<Hsp> swipe_dispatch_cbs(
 }
 
 template<typename _sv, typename _traceback>
-list<Hsp> full_swipe_dispatch_cbs(
+vector<Hsp> full_swipe_dispatch_cbs(
 	const Sequence&query,
 	Frame frame,
 	DynamicIterator<DpTarget>& targets,
@@ -86,8 +92,20 @@ list<Hsp> full_swipe_dispatch_cbs(
 		return DP::Swipe::DISPATCH_ARCH::swipe<_sv, _traceback>(query, frame, targets, composition_bias, overflow, stat);
 }
 
+// Traceback used for targets above --traceback-checkpoint-dp. Only the 32 bit kernel, which processes such targets one at
+// a time, supports checkpointing.
+template<typename _sv>
+struct LargeTraceback {
+	typedef VectorTraceback Type;
+};
+
+template<>
+struct LargeTraceback<int32_t> {
+	typedef CheckpointTraceback Type;
+};
+
 template<typename _sv>
-list<Hsp> swipe_targets(const Sequence&query,
+vector<Hsp> swipe_targets(const Sequence&query,
 	vector<DpTarget>::const_iterator begin,
 	vector<DpTarget>::const_iterator end,
 	DynamicIterator<DpTarget>* targets,
@@ -98,7 +116,7 @@ list<Hsp> swipe_targets(const Sequence&query,
 	Statistics &stat)
 {
 	constexpr auto CHANNELS = vector<DpTarget>::const_iterator::difference_type(::DISPATCH_ARCH::ScoreTraits<_sv>::CHANNELS);
-	list<Hsp> out;
+	vector<Hsp> out;
 	if (flags & DP::FULL_MATRIX) {
 		if (flags & TRACEBACK)
 			return full_swipe_dispatch_cbs<_sv, VectorTraceback>(query, frame, *targets, composition_bias, overflow, stat);
@@ -109,10 +127,12 @@ list<Hsp> swipe_targets(const Sequence&query,
 	}
 	else {
 		for (vector<DpTarget>::const_iterator i = begin; i < end; i += std::min(CHANNELS, end - i)) {
-			if (flags & TRACEBACK)
-				out.splice(out.end(), swipe_dispatch_cbs<_sv, VectorTraceback>(query, frame, i, i + std::min(CHANNELS, end - i), composition_bias, overflow, stat));
+			if ((flags & TRACEBACK) && CHANNELS == 1 && size_t(i->d_end - i->d_begin) * i->seq.length() > config.traceback_checkpoint_dp)
+				append(out, swipe_dispatch_cbs<_sv, typename LargeTraceback<_sv>::Type>(query, frame, i, i + 1, composition_bias, overflow, stat));
+			else if (flags & TRACEBACK)
+				append(out, swipe_dispatch_cbs<_sv, VectorTraceback>(query, frame, i, i + std::min(CHANNELS, end - i), composition_bias, overflow, stat));
 			else
-				out.splice(out.end(), swipe_dispatch_cbs<_sv, ScoreOnly>(query, frame, i, i + std::min(CHANNELS, end - i), composition_bias, overflow, stat));
+				append(out, swipe_dispatch_cbs<_sv, ScoreOnly>(query, frame, i, i + std::min(CHANNELS, end - i), composition_bias, overflow, stat));
 		}
 	}
 	return out;
@@ -127,7 +147,7 @@ void swipe_worker(const Sequence*query,
 	Frame frame,
 	const int8_t *composition_bias,
 	int flags,
-	list<Hsp> *out,
+	vector<Hsp> *out,
 	vector<DpTarget> *overflow,
 	Statistics *stat)
 {
@@ -136,16 +156,16 @@ void swipe_worker(const Sequence*query,
 	vector<DpTarget> of;
 	if (targets == nullptr) {
 		while (begin + (pos = next->fetch_add(::DISPATCH_ARCH::ScoreTraits<_sv>::CHANNELS)) < end)
-			out->splice(out->end(), swipe_targets<_sv>(*query, begin + pos, std::min(begin + pos + ::DISPATCH_ARCH::ScoreTraits<_sv>::CHANNELS, end), nullptr, frame, composition_bias, flags, of, stat2));
+			append(*out, swipe_targets<_sv>(*query, begin + pos, std::min(begin + pos + ::DISPATCH_ARCH::ScoreTraits<_sv>::CHANNELS, end), nullptr, frame, composition_bias, flags, of, stat2));
 	}
 	else
-		out->splice(out->end(), swipe_targets<_sv>(*query, begin, end, targets, frame, composition_bias, flags, of, stat2));
+		append(*out, swipe_targets<_sv>(*query, begin, end, targets, frame, composition_bias, flags, of, stat2));
 	*overflow = std::move(of);
 	*stat += stat2;
 }
 
 template<typename _sv>
-list<Hsp> swipe_threads(const Sequence& query,
+vector<Hsp> swipe_threads(const Sequence& query,
 	vector<DpTarget>::const_iterator begin,
 	vector<DpTarget>::const_iterator end,
 	DynamicIterator<DpTarget>* targets,
@@ -165,7 +185,7 @@ list<Hsp> swipe_threads(const Sequence& query,
 		task_timer timer("Banded swipe (run)", config.target_parallel_verbosity);
 		const size_t n = config.threads_align ? config.threads_align : config.threads_;
 		vector<thread> threads;
-		vector<list<Hsp>> thread_out(n);
+		vector<vector<Hsp>> thread_out(n);
 		vector<vector<DpTarget>> thread_overflow(n);
 		atomic<size_t> next(0);
 		for (size_t i = 0; i < n; ++i)
@@ -185,9 +205,10 @@ list<Hsp> swipe_threads(const Sequence& query,
 		for (auto &t : threads)
 			t.join();
 		timer.go("Banded swipe (merge)");
-		list<Hsp> out;
-		for (list<Hsp> &l : thread_out)
-			out.splice(out.end(), l);
+		vector<Hsp> out;
+		out.reserve(std::accumulate(thread_out.begin(), thread_out.end(), (size_t)0, [](size_t n, const vector<Hsp>& v) { return n + v.size(); }));
+		for (vector<Hsp> &v : thread_out)
+			append(out, std::move(v));
 		overflow.reserve(std::accumulate(thread_overflow.begin(), thread_overflow.end(), (size_t)0, [](size_t n, const vector<DpTarget> &v) { return n + v.size(); }));
 		for (const vector<DpTarget> &v : thread_overflow)
 			overflow.insert(overflow.end(), v.begin(), v.end());
@@ -197,7 +218,7 @@ list<Hsp> swipe_threads(const Sequence& query,
 		return swipe_targets<_sv>(query, begin, end, targets ? targets : my_targets.get(), frame, composition_bias, flags, overflow, stat);
 }
 
-list<Hsp> recompute_reversed(const Sequence& query, Frame frame, const Bias_correction* composition_bias, int flags, Statistics& stat, list<Hsp>::const_iterator begin, list<Hsp>::const_iterator end) {
+vector<Hsp> recompute_reversed(const Sequence& query, Frame frame, const Bias_correction* composition_bias, QueryProfiles* profiles, int flags, Statistics& stat, vector<Hsp>::const_iterator begin, vector<Hsp>::const_iterator end) {
 	array<vector<DpTarget>, 3> dp_targets;
 	vector<DpTarget> overflow;
 	SequenceSet reversed_targets;
@@ -221,23 +242,38 @@ list<Hsp> recompute_reversed(const Sequence& query, Frame frame, const Bias_corr
 		dp_targets[b].emplace_back(reversed_targets[j], i->swipe_target, i->query_range.end_, i->subject_range.end_);
 	}
 
-	list<Hsp> out;
-	vector<Letter> reversed = query.reverse();
-	Bias_correction rev_cbs = composition_bias ? composition_bias->reverse() : Bias_correction();
+	vector<Hsp> out;
+	vector<Letter> reversed_buf;
+	Bias_correction rev_cbs_buf;
+	Sequence reversed;
+	const int8_t* rev_cbs = nullptr;
+	if (profiles) {
+		reversed = profiles->reversed(frame.index());
+		if (composition_bias)
+			rev_cbs = profiles->reversed_cb(frame.index()).int8.data();
+	}
+	else {
+		reversed_buf = query.reverse();
+		reversed = Sequence(reversed_buf);
+		if (composition_bias) {
+			rev_cbs_buf = composition_bias->reverse();
+			rev_cbs = rev_cbs_buf.int8.data();
+		}
+	}
 #ifdef __SSE4_1__
-	out = swipe_threads<::DISPATCH_ARCH::score_vector<int8_t>>(Sequence(reversed), dp_targets[0].begin(), dp_targets[0].end(), nullptr, frame, composition_bias ? rev_cbs.int8.data() : nullptr, flags, overflow, stat);
+	out = swipe_threads<::DISPATCH_ARCH::score_vector<int8_t>>(reversed, dp_targets[0].begin(), dp_targets[0].end(), nullptr, frame, rev_cbs, flags, overflow, stat);
 #endif
 #ifdef __SSE2__
-	out.splice(out.end(), swipe_threads<::DISPATCH_ARCH::score_vector<int16_t>>(Sequence(reversed), dp_targets[1].begin(), dp_targets[1].end(), nullptr, frame, composition_bias ? rev_cbs.int8.data() : nullptr, flags, overflow, stat));
+	append(out, swipe_threads<::DISPATCH_ARCH::score_vector<int16_t>>(reversed, dp_targets[1].begin(), dp_targets[1].end(), nullptr, frame, rev_cbs, flags, overflow, stat));
 #endif
-	out.splice(out.end(), swipe_threads<int32_t>(Sequence(reversed), dp_targets[2].begin(), dp_targets[2].end(), nullptr, frame, composition_bias ? rev_cbs.int8.data() : nullptr, flags, overflow, stat));
+	append(out, swipe_threads<int32_t>(reversed, dp_targets[2].begin(), dp_targets[2].end(), nullptr, frame, rev_cbs, flags, overflow, stat));
 	return out;
 }
 
-list<Hsp> swipe(const Sequence &query, vector<DpTarget> &targets8, const vector<DpTarget> &targets16, const vector<DpTarget>& targets32, DynamicIterator<DpTarget>* targets, Frame frame, const Bias_correction *composition_bias, int flags, Statistics &stat)
+vector<Hsp> swipe(const Sequence &query, vector<DpTarget> &targets8, const vector<DpTarget> &targets16, const vector<DpTarget>& targets32, DynamicIterator<DpTarget>* targets, Frame frame, const Bias_correction *composition_bias, QueryProfiles* profiles, int flags, Statistics &stat)
 {
 	vector<DpTarget> overflow8, overflow16, overflow32;
-	list<Hsp> out;
+	vector<Hsp> out;
 	auto time_stat = (flags & TRACEBACK) ? Statistics::TIME_TRACEBACK_SW : Statistics::TIME_SW;
 #ifdef __SSE4_1__
 	if (!targets8.empty() || targets) {
@@ -264,17 +300,17 @@ list<Hsp> swipe(const Sequence &query, vector<DpTarget> &targets8, const vector<
 			std::sort(overflow8.begin(), overflow8.end());
 		stat.inc(Statistics::TIME_TARGET_SORT, timer.microseconds());
 		timer.go();
-		out.splice(out.end(), swipe_threads<::DISPATCH_ARCH::score_vector<int16_t>>(query, overflow8.begin(), overflow8.end(), nullptr, frame, composition_bias ? composition_bias->int8.data() : nullptr, flags, overflow16, stat));
+		append(out, swipe_threads<::DISPATCH_ARCH::score_vector<int16_t>>(query, overflow8.begin(), overflow8.end(), nullptr, frame, composition_bias ? composition_bias->int8.data() : nullptr, flags, overflow16, stat));
 		if ((flags & PARALLEL) == 0) stat.inc(time_stat, timer.microseconds());
 		if (!overflow16.empty() || !targets32.empty()) {
 			overflow16.insert(overflow16.end(), targets32.begin(), targets32.end());
 			stat.inc(Statistics::EXT32, overflow16.size());
 			timer.go();
-			out.splice(out.end(), swipe_threads<int32_t>(query, overflow16.begin(), overflow16.end(), nullptr, frame, composition_bias ? composition_bias->int8.data() : nullptr, flags, overflow32, stat));
+			append(out, swipe_threads<int32_t>(query, overflow16.begin(), overflow16.end(), nullptr, frame, composition_bias ? composition_bias->int8.data() : nullptr, flags, overflow32, stat));
 			stat.inc(time_stat, timer.microseconds());
 		}
 	}
-	return (flags & DP::WITH_COORDINATES) ? recompute_reversed(query, frame, composition_bias, flags, stat, out.begin(), out.end()) : out;
+	return (flags & DP::WITH_COORDINATES) ? recompute_reversed(query, frame, composition_bias, profiles, flags, stat, out.begin(), out.end()) : out;
 #else
 	overflow8.insert(overflow8.end(), targets16.begin(), targets16.end());
 	stat.inc(Statistics::EXT32, overflow8.size());
@@ -19,10 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <assert.h>
 #include <algorithm>
 #include "score_vector_int8.h"
+#include "score_vector_int16.h"
 #include "../util/simd/vector.h"
 #include "ungapped_simd.h"
 #include "../util/simd/transpose.h"
 #include "ungapped.h"
+#include "../basic/config.h"
 
 using namespace DISPATCH_ARCH;
 
@@ -84,4 +86,97 @@ void window_ungapped_best(const Letter* query, const Letter** subjects, int subj
 #endif
 }
 
-}}
\ No newline at end of file
+#ifdef __SSE4_1__
+
+// Extends up to CHANNELS hits in one direction, one hit per lane. Scores are kept in 16 bit, lanes that may
+// have saturated are flagged in the returned mask and need to be recomputed by the caller.
+static uint32_t xdrop_extend(const Letter* const* query, const Letter* const* subject, int count, int dir, const int16_t* start, int16_t* score_out, int16_t* len_out) {
+	typedef score_vector<int16_t> Sv;
+	constexpr int CHANNELS = ::DISPATCH_ARCH::ScoreTraits<Sv>::CHANNELS;
+	constexpr int16_t SATURATION_LIMIT = SHRT_MAX - 128;
+	assert(count <= CHANNELS);
+
+	const int xdrop = config.raw_ungapped_xdrop;
+	alignas(32) int16_t match[CHANNELS], drop[CHANNELS];
+	const Letter* q[CHANNELS], * s[CHANNELS];
+	std::copy(query, query + count, q);
+	std::copy(subject, subject + count, s);
+	std::fill(match, match + CHANNELS, 0);
+	std::fill(drop, drop + CHANNELS, 0);
+	std::copy(start, start + count, score_out);
+	std::fill(score_out + count, score_out + CHANNELS, 0);
+
+	Sv st(score_out), best = st, len(0);
+	uint32_t active = (1u << count) - 1, saturated = 0;
+	for (int n = 1; active; ++n) {
+		if (n >= SATURATION_LIMIT) {
+			saturated = active;
+			break;
+		}
+		for (int i = 0; i < count; ++i) {
+			match[i] = 0;
+			if ((active & (1u << i)) == 0)
+				continue;
+			const Letter ql = *q[i], sl = *s[i];
+			if (drop[i] >= xdrop || ql == Sequence::DELIMITER || sl == Sequence::DELIMITER) {
+				active &= ~(1u << i);
+				continue;
+			}
+#ifdef SEQ_MASK
+			match[i] = (int16_t)score_matrix(letter_mask(ql), letter_mask(sl));
+#else
+			match[i] = (int16_t)score_matrix(ql, sl);
+#endif
+			q[i] += dir;
+			s[i] += dir;
+		}
+		st += Sv(match);
+		const Sv new_best = max(best, st);
+		len = blend(Sv(n), len, new_best == best);
+		best = new_best;
+		(best - st).store(drop);
+	}
+
+	best.store(score_out);
+	len.store(len_out);
+	for (int i = 0; i < count; ++i)
+		if (score_out[i] >= SATURATION_LIMIT)
+			saturated |= 1u << i;
+	return saturated;
+}
+
+#endif
+
+void xdrop_ungapped_batch(const Sequence& query, const Sequence& subject, const int* qa, const int* sa, int count, Diagonal_segment* out) {
+#ifdef __SSE4_1__
+	constexpr int CHANNELS = ::DISPATCH_ARCH::ScoreTraits<score_vector<int16_t>>::CHANNELS;
+	const Letter* q[CHANNELS], * s[CHANNELS];
+	alignas(32) int16_t zero[CHANNELS], left_score[CHANNELS], delta[CHANNELS], score[CHANNELS], len[CHANNELS];
+	std::fill(zero, zero + CHANNELS, 0);
+	for (int i0 = 0; i0 < count; i0 += CHANNELS) {
+		const int n = std::min(count - i0, CHANNELS);
+		for (int i = 0; i < n; ++i) {
+			q[i] = query.data() + qa[i0 + i] - 1;
+			s[i] = subject.data() + sa[i0 + i] - 1;
+		}
+		uint32_t saturated = xdrop_extend(q, s, n, -1, zero, left_score, delta);
+		for (int i = 0; i < n; ++i) {
+			q[i] = query.data() + qa[i0 + i];
+			s[i] = subject.data() + sa[i0 + i];
+		}
+		saturated |= xdrop_extend(q, s, n, 1, left_score, score, len);
+		for (int i = 0; i < n; ++i) {
+			const int j = i0 + i;
+			if (saturated & (1u << i))
+				out[j] = ::xdrop_ungapped(query, subject, qa[j], sa[j]);
+			else
+				out[j] = Diagonal_segment(qa[j] - delta[i], sa[j] - delta[i], len[i] + delta[i], score[i]);
+		}
+	}
+#else
+	for (int i = 0; i < count; ++i)
+		out[i] = ::xdrop_ungapped(query, subject, qa[i], sa[i]);
+#endif
+}
+
+}}
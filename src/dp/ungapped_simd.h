@@ -19,10 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include "../util/simd.h"
 #include "../basic/value.h"
+#include "../basic/sequence.h"
+#include "../basic/diagonal_segment.h"
 
 namespace DP {
 
 DECL_DISPATCH(void, window_ungapped, (const Letter* query, const Letter** subjects, int subject_count, int window, int* out))
 DECL_DISPATCH(void, window_ungapped_best, (const Letter* query, const Letter** subjects, int subject_count, int window, int* out))
+DECL_DISPATCH(void, xdrop_ungapped_batch, (const Sequence& query, const Sequence& subject, const int* qa, const int* sa, int count, Diagonal_segment* out))
 
 }
\ No newline at end of file
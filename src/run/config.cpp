@@ -3,6 +3,7 @@
 #include "../data/block.h"
 #include "../data/taxonomy_nodes.h"
 #include "../data/sequence_file.h"
+#include "../data/frequent_seeds.h"
 #include "../search/hit.h"
 #include "../util/async_buffer.h"
 #include "../search/hit.h"
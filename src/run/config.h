@@ -30,6 +30,7 @@ struct Consumer;
 struct TextInputFile;
 struct Block;
 struct TaxonomyNodes;
+struct SeedFrequencyTable;
 enum class Sensitivity;
 enum class SeedEncoding;
 template<typename T> struct AsyncBuffer;
@@ -66,6 +67,7 @@ struct Config {
 	double                                     gapped_filter_evalue;
 	unsigned                                   index_chunks;
 	unsigned                                   query_bins;
+	unsigned                                   seed_window;
 
 	std::shared_ptr<SequenceFile>              db;
 	std::shared_ptr<std::list<TextInputFile>>  query_file;
@@ -79,6 +81,7 @@ struct Config {
 	std::unique_ptr<AsyncBuffer<Hit>>          seed_hit_buf;
 	std::unique_ptr<RankingBuffer>             global_ranking_buffer;
 	std::unique_ptr<RankingTable>              ranking_table;
+	std::unique_ptr<SeedFrequencyTable>        seed_freq;
 
 	uint64_t db_seqs, db_letters, ref_blocks;
 	Util::Scores::CutoffTable cutoff_gapped1, cutoff_gapped2;
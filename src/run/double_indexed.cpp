@@ -135,17 +135,23 @@ void run_ref_chunk(SequenceFile &db_file,
 			{ cfg.target->long_offsets(), align_mode.query_contexts }));
 
 	if (!config.swipe_all) {
-		timer.go("Building reference histograms");
-		if(query_seeds_bitset.get())
-			cfg.target->hst() = Partitioned_histogram(ref_seqs, true, query_seeds_bitset.get(), cfg.seed_encoding, nullptr);
-		else if (query_seeds_hashed.get())
-			cfg.target->hst() = Partitioned_histogram(ref_seqs, true, query_seeds_hashed.get(), cfg.seed_encoding, nullptr);
-		else
-			cfg.target->hst() = Partitioned_histogram(ref_seqs, false, &no_filter, cfg.seed_encoding, nullptr);
+		// the contiguous seed index joins the reference seeds directly
+		char *ref_buffer = nullptr;
+		if (!query_seeds_ctg.get()) {
+			timer.go("Building reference histograms");
+			if (query_seeds_hashed.get())
+				cfg.target->hst() = Partitioned_histogram(ref_seqs, true, query_seeds_hashed.get(), cfg.seed_encoding, nullptr);
+			else if (cfg.seed_window) {
+				const SyncmerFilter filter(cfg.seed_window);
+				cfg.target->hst() = Partitioned_histogram(ref_seqs, false, &filter, cfg.seed_encoding, nullptr);
+			}
+			else
+				cfg.target->hst() = Partitioned_histogram(ref_seqs, false, &no_filter, cfg.seed_encoding, nullptr);
 
-		timer.go("Allocating buffers");
-		char *ref_buffer = SeedArray::alloc_buffer(cfg.target->hst(), cfg.index_chunks);
-		timer.finish();
+			timer.go("Allocating buffers");
+			ref_buffer = SeedArray::alloc_buffer(cfg.target->hst(), cfg.index_chunks);
+			timer.finish();
+		}
 
 		HashedSeedSet* target_seeds = nullptr;
 		if (config.target_indexed) {
@@ -247,7 +253,7 @@ void run_query_iteration(const unsigned query_chunk,
 	}
 	if (config.algo == ::Config::Algo::CTG_SEED) {
 		timer.go("Building query seed set");
-		query_seeds_bitset.reset(new SeedSet(query_seqs, 1.0, options.query_skip.get()));
+		query_seeds_ctg.reset(new ContiguousSeedIndex(query_seqs, options.query_skip.get()));
 		options.seed_encoding = SeedEncoding::CONTIGUOUS;
 		timer.finish();
 	}
@@ -260,9 +266,14 @@ void run_query_iteration(const unsigned query_chunk,
 	options.cutoff_gapped1_new = { config.gapped_filter_evalue1 };
 	options.cutoff_gapped2_new = { options.gapped_filter_evalue };
 
+	if (options.seed_encoding != SeedEncoding::SPACED_FACTOR)
+		options.seed_window = 0;
+
 	if (current_query_chunk == 0 && query_iteration == 0) {
 		message_stream << "Algorithm: " << to_string(config.algo) << endl;
 		verbose_stream << "Seed frequency SD: " << options.freq_sd << endl;
+		if (options.seed_window)
+			verbose_stream << "Reference seed subsampling: closed syncmers, window = " << options.seed_window << endl;
 		verbose_stream << "Shape configuration: " << ::shapes << endl;
 	}	
 
@@ -272,7 +283,7 @@ void run_query_iteration(const unsigned query_chunk,
 	}
 
 	char* query_buffer = nullptr;
-	if (!config.swipe_all && !config.target_indexed) {
+	if (!config.swipe_all && !config.target_indexed && !query_seeds_ctg.get()) {
 		timer.go("Building query histograms");
 		options.query->hst() = Partitioned_histogram(query_seqs, false, &no_filter, options.seed_encoding, options.query_skip.get());
 
@@ -337,7 +348,7 @@ void run_query_iteration(const unsigned query_chunk,
 	timer.go("Deallocating buffers");
 	delete[] query_buffer;
 	query_seeds_hashed.reset();
-	query_seeds_bitset.reset();
+	query_seeds_ctg.reset();
 	options.query_skip.reset();
 	delete Extension::memory;
 
@@ -722,6 +733,10 @@ void run(const shared_ptr<SequenceFile>& db, const shared_ptr<std::list<TextInpu
 		timer.finish();
 	}
 
+	cfg.seed_freq.reset(cfg.db->seed_freq_table());
+	if (cfg.seed_freq)
+		verbose_stream << "Using the seed frequency table of the database." << endl;
+
 	if (!config.seqidlist.empty()) {
 		message_stream << "Filtering database by accession list: " << config.seqidlist << endl;
 		timer.go("Building database filter");
@@ -83,6 +83,8 @@ int main(int ac, const char* av[])
 			break;
 		case Config::blastp:
 		case Config::blastx:
+			if (config.autotune)
+				Search::autotune();
 			Search::run();
 			break;
 		case Config::view:
@@ -131,6 +133,8 @@ int main(int ac, const char* av[])
 					throw e;
 				}
 			}
+			if (config.autotune)
+				Search::autotune();
 			Workflow::Cluster::ClusterRegistry::get(config.cluster_algo)->run();
 			break;
 		case Config::translate:
@@ -28,5 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace Search {
 
 void run(const std::shared_ptr<SequenceFile>& db = nullptr, const std::shared_ptr<std::list<TextInputFile>>& query = nullptr, const std::shared_ptr<Consumer>& out = nullptr, const std::shared_ptr<BitVector>& db_filter = nullptr);
+// Sets config.tile_size and config.radix_bits where not given on the command line, by calibration runs or from the
+// previous selection for this host.
+void autotune();
 
 }
@@ -0,0 +1,179 @@
+/****
+DIAMOND protein aligner
+Copyright (C) 2021 Max Planck Society for the Advancement of Science e.V.
+
+Code developed by Benjamin Buchfink <benjamin.buchfink@tue.mpg.de>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+****/
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <stdlib.h>
+#include "search.h"
+#include "../run/workflow.h"
+#include "../util/algo/hash_join.h"
+#include "../util/system/system.h"
+#include "../util/log_stream.h"
+#include "../util/simd.h"
+#include "../basic/const.h"
+
+using std::string;
+using std::vector;
+using std::endl;
+
+namespace Search {
+
+static const size_t TILE_SIZES[] = { 128, 256, 512, 1024, 2048 };
+static const unsigned RADIX_BITS[] = { 6, 7, 8, 9, 10, 11 };
+static const size_t DEFAULT_TILE_SIZE = 1024;
+static const unsigned DEFAULT_RADIX_BITS = 8;
+// fingerprints per side of the calibration seed group
+static const size_t TILE_GROUP_SIZE = 8192;
+// entries per relation of the calibration hash join, large enough to take the radix clustering path
+static const size_t JOIN_SIZE = 1 << 21;
+static const unsigned HAMMING_FILTER_ID = 11;
+// a candidate has to beat the default by this factor to be selected, so that timing noise does not change the setting
+static const double MIN_GAIN = 1.05;
+
+struct Tuning {
+	size_t tile_size;
+	unsigned radix_bits;
+	double tile_rate, join_rate;
+};
+
+// Identifies the host and the parts of its configuration that the tuning depends on.
+static string host_key() {
+	std::ostringstream s;
+	s << hostname() << '|' << std::thread::hardware_concurrency() << '|' << l2_cache_size() << '|' << l3_cache_size() << '|'
+		<< SIMD::features() << '|' << Const::version_string << '.' << (unsigned)Const::build_version;
+	string k = s.str();
+	std::replace(k.begin(), k.end(), '\t', ' ');
+	return k;
+}
+
+static string cache_file() {
+	const char* home = getenv("HOME");
+	return home ? string(home) + "/.diamond_autotune" : string();
+}
+
+static bool load(const string& file, const string& key, Tuning& t) {
+	std::ifstream in(file);
+	string line;
+	while (std::getline(in, line)) {
+		const size_t i = line.find('\t');
+		if (i != key.length() || line.compare(0, i, key) != 0)
+			continue;
+		std::istringstream s(line.substr(i + 1));
+		if (s >> t.tile_size >> t.radix_bits >> t.tile_rate >> t.join_rate)
+			return true;
+	}
+	return false;
+}
+
+static void store(const string& file, const string& key, const Tuning& t) {
+	vector<string> lines;
+	{
+		std::ifstream in(file);
+		string line;
+		while (std::getline(in, line))
+			if (line.compare(0, key.length() + 1, key + '\t') != 0)
+				lines.push_back(line);
+	}
+	std::ofstream out(file);
+	for (const string& l : lines)
+		out << l << endl;
+	out << key << '\t' << t.tile_size << '\t' << t.radix_bits << '\t' << t.tile_rate << '\t' << t.join_rate << endl;
+}
+
+// Seed entries per second joined by hash_join with the given number of radix bits per clustering pass.
+static double join_rate(unsigned radix_bits, const vector<SeedArray::Entry>& r, const vector<SeedArray::Entry>& s) {
+	config.radix_bits = radix_bits;
+	double best = 0.0;
+	for (int i = 0; i < 3; ++i) {
+		vector<SeedArray::Entry> r2(r), s2(s);
+		const auto begin = std::chrono::high_resolution_clock::now();
+		hash_join(Relation<SeedArray::Entry>(r2.data(), r2.size()), Relation<SeedArray::Entry>(s2.data(), s2.size()), 32);
+		const double t = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+		best = std::max(best, (r.size() + s.size()) / t);
+	}
+	return best;
+}
+
+// Leaves config.radix_bits unchanged, it is set by the caller for the options that were left unset.
+static Tuning calibrate() {
+	const unsigned radix_bits = config.radix_bits;
+	Tuning t{ DEFAULT_TILE_SIZE, DEFAULT_RADIX_BITS, tile_throughput(TILE_GROUP_SIZE, DEFAULT_TILE_SIZE, HAMMING_FILTER_ID), 0.0 };
+	const double tile_default = t.tile_rate;
+	for (size_t tile_size : TILE_SIZES) {
+		if (tile_size == DEFAULT_TILE_SIZE)
+			continue;
+		const double rate = tile_throughput(TILE_GROUP_SIZE, tile_size, HAMMING_FILTER_ID);
+		verbose_stream << "Tile size " << tile_size << ": " << rate << " pairs/s" << endl;
+		if (rate > t.tile_rate && rate > tile_default * MIN_GAIN) {
+			t.tile_size = tile_size;
+			t.tile_rate = rate;
+		}
+	}
+
+	std::mt19937 rng(0);
+	vector<SeedArray::Entry> r(JOIN_SIZE), s(JOIN_SIZE);
+	for (size_t i = 0; i < JOIN_SIZE; ++i) {
+		r[i] = SeedArray::Entry((uint32_t)rng(), SeedArray::_pos(i));
+		s[i] = SeedArray::Entry((uint32_t)rng(), SeedArray::_pos(i));
+	}
+	t.join_rate = join_rate(DEFAULT_RADIX_BITS, r, s);
+	const double join_default = t.join_rate;
+	for (unsigned bits : RADIX_BITS) {
+		if (bits == DEFAULT_RADIX_BITS)
+			continue;
+		const double rate = join_rate(bits, r, s);
+		verbose_stream << "Radix bits " << bits << ": " << rate << " entries/s" << endl;
+		if (rate > t.join_rate && rate > join_default * MIN_GAIN) {
+			t.radix_bits = bits;
+			t.join_rate = rate;
+		}
+	}
+	config.radix_bits = radix_bits;
+	return t;
+}
+
+void autotune() {
+	const bool tile_size = config.tile_size == 0, radix_bits = config.radix_bits == 0;
+	if (!tile_size && !radix_bits)
+		return;
+	const string key = host_key(), file = cache_file();
+	Tuning t;
+	if (file.empty() || !load(file, key, t)) {
+		task_timer timer("Calibrating tile size and radix bits");
+		t = calibrate();
+		timer.finish();
+		if (!file.empty())
+			store(file, key, t);
+	}
+	else
+		verbose_stream << "Loaded tuning parameters from " << file << endl;
+	if (tile_size)
+		config.tile_size = t.tile_size;
+	if (radix_bits)
+		config.radix_bits = t.radix_bits;
+	message_stream << "Autotuning: L2 cache = " << l2_cache_size() << ", L3 cache = " << l3_cache_size() << ", tile size = " << config.tile_size
+		<< (tile_size ? "" : " (user)") << ", radix bits = " << config.radix_bits << (radix_bits ? "" : " (user)") << endl;
+}
+
+}
@@ -124,6 +124,67 @@ struct Byte_finger_print_48
 
 #endif
 
+// Bit-sliced form of Byte_finger_print_48. Plane k holds bit k of the 5-bit letter codes at the 48 positions around
+// a seed hit, so that two fingerprints are compared with a few 64-bit XOR/OR operations and a popcount.
+struct Bitsliced_finger_print_48
+{
+	static constexpr int PLANES = 5;
+	static constexpr uint64_t POSITION_MASK = (uint64_t(1) << 48) - 1;
+
+	Bitsliced_finger_print_48(const Letter* q)
+	{
+#ifdef __SSE2__
+		const __m128i r1 = load(q - 16), r2 = load(q), r3 = load(q + 16);
+		plane[0] = bits<7>(r1, r2, r3);
+		plane[1] = bits<6>(r1, r2, r3);
+		plane[2] = bits<5>(r1, r2, r3);
+		plane[3] = bits<4>(r1, r2, r3);
+		plane[4] = bits<3>(r1, r2, r3);
+#else
+		std::fill(plane, plane + PLANES, 0);
+		for (int i = 0; i < 48; ++i) {
+			const Letter l = letter_mask(q[i - 16]);
+			for (int k = 0; k < PLANES; ++k)
+				plane[k] |= uint64_t((l >> k) & 1) << (i < 16 ? i + 16 : (i < 32 ? i - 16 : i));
+		}
+#endif
+	}
+
+	// Number of positions with identical letters in two fingerprints stored with the given plane strides.
+	static unsigned match(const uint64_t* x, size_t x_stride, const uint64_t* y, size_t y_stride)
+	{
+		uint64_t diff = 0;
+		for (int k = 0; k < PLANES; ++k)
+			diff |= x[k * x_stride] ^ y[k * y_stride];
+		return popcount64(~diff & POSITION_MASK);
+	}
+
+	uint64_t plane[PLANES];
+
+private:
+
+#ifdef __SSE2__
+	static __m128i load(const Letter* q)
+	{
+#ifdef SEQ_MASK
+		return letter_mask(_mm_loadu_si128((__m128i const*)q));
+#else
+		return _mm_loadu_si128((__m128i const*)q);
+#endif
+	}
+
+	// Moves bit 7-SHIFT of each byte to the sign bit, using the same block order as Byte_finger_print_48.
+	template<int SHIFT>
+	static uint64_t bits(__m128i r1, __m128i r2, __m128i r3)
+	{
+		return (uint64_t)_mm_movemask_epi8(_mm_slli_epi16(r3, SHIFT)) << 32
+			| (uint64_t)_mm_movemask_epi8(_mm_slli_epi16(r1, SHIFT)) << 16
+			| (uint64_t)_mm_movemask_epi8(_mm_slli_epi16(r2, SHIFT));
+	}
+#endif
+
+};
+
 #ifdef __AVX2__
 typedef Byte_finger_print_48 FingerPrint;
 #else
@@ -47,6 +47,8 @@ struct SensitivityTraits {
 	const double   gapped_filter_evalue;
 	const unsigned index_chunks;
 	const unsigned query_bins;
+	// closed syncmer window of the positional subsampling of reference seeds (--subsample-seeds), 0 = not supported
+	const unsigned seed_window;
 	const char*    contiguous_seed;
 };
 
@@ -104,11 +106,14 @@ struct WorkSet {
 	Writer<Hit>* out;
 #ifndef __APPLE__
 	std::vector<FingerPrint, Util::Memory::AlignmentAllocator<FingerPrint, 16>> vq, vs;
+	std::vector<uint64_t> pq, ps;
 #endif
 	FlatArray<uint32_t> hits;
 };
 
 DECL_DISPATCH(void, stage1, (const SeedArray::Entry::Value* q, size_t nq, const SeedArray::Entry::Value* s, size_t ns, WorkSet& work_set))
+// Fingerprint pairs per second compared by the stage 1 tile loop for an n x n group of random seed hits.
+DECL_DISPATCH(double, tile_throughput, (size_t n, size_t tile_size, unsigned hamming_filter_id))
 
 }
 
@@ -33,14 +33,14 @@ double SeedComplexity::prob_[AMINO_ACID_COUNT];
 const double SINGLE_INDEXED_SEED_SPACE_MAX_COVERAGE = 0.15;
 
 const map<Sensitivity, SensitivityTraits> sensitivity_traits {
-	//                               qidx   freqsd minid ug_ev   ug_ev_s gf_ev  idx_chunk qbins ctg_seed
-	{ Sensitivity::FAST,            {true,  50.0,  11,   10000,  10000,  0,     4,        16,   nullptr }},
-	{ Sensitivity::DEFAULT,         {true,  50.0,  11,   10000,  10000,  0,     4,        16,   "111111" }},
-	{ Sensitivity::MID_SENSITIVE,   {true,  20.0,  11,   10000,  10000,  0,     4,        16,   nullptr }},
-	{ Sensitivity::SENSITIVE,       {true,  20.0,  11,   10000,  10000,  1,     4,        16,   "11111" }},
-	{ Sensitivity::MORE_SENSITIVE,  {true,  200.0, 11,   10000,  10000,  1,     4,        16,   "11111" }},
-	{ Sensitivity::VERY_SENSITIVE,  {true,  15.0,  9,    100000, 30000,  1,     1,        16,   nullptr }},
-	{ Sensitivity::ULTRA_SENSITIVE, {true,  20.0,  9,    300000, 30000,  1,     1,        64,   nullptr }}
+	//                               qidx   freqsd minid ug_ev   ug_ev_s gf_ev  idx_chunk qbins seed_win ctg_seed
+	{ Sensitivity::FAST,            {true,  50.0,  11,   10000,  10000,  0,     4,        16,   4,       nullptr }},
+	{ Sensitivity::DEFAULT,         {true,  50.0,  11,   10000,  10000,  0,     4,        16,   0,       "111111" }},
+	{ Sensitivity::MID_SENSITIVE,   {true,  20.0,  11,   10000,  10000,  0,     4,        16,   0,       nullptr }},
+	{ Sensitivity::SENSITIVE,       {true,  20.0,  11,   10000,  10000,  1,     4,        16,   0,       "11111" }},
+	{ Sensitivity::MORE_SENSITIVE,  {true,  200.0, 11,   10000,  10000,  1,     4,        16,   0,       "11111" }},
+	{ Sensitivity::VERY_SENSITIVE,  {true,  15.0,  9,    100000, 30000,  1,     1,        16,   0,       nullptr }},
+	{ Sensitivity::ULTRA_SENSITIVE, {true,  20.0,  9,    300000, 30000,  1,     1,        64,   0,       nullptr }}
 };
 
 const map<Sensitivity, vector<Sensitivity>> iterated_sens{
@@ -210,6 +210,7 @@ void setup_search(Sensitivity sens, Search::Config& cfg)
 	Config::set_option(cfg.ungapped_evalue_short, config.ungapped_evalue_short_, -1.0, traits.ungapped_evalue_short);
 	Config::set_option(cfg.gapped_filter_evalue, config.gapped_filter_evalue_, -1.0, traits.gapped_filter_evalue);
 	Config::set_option(cfg.query_bins, config.query_bins_, 0u, traits.query_bins);
+	cfg.seed_window = config.subsample_seeds ? traits.seed_window : 0;
 
 	if (config.algo == Config::Algo::CTG_SEED) {
 		if (!traits.contiguous_seed)
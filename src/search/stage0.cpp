@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../util/algo/radix_sort.h"
 #include "../data/reference.h"
 #include "../data/seed_array.h"
+#include "../data/seed_set.h"
 #include "../data/queries.h"
 #include "../data/frequent_seeds.h"
 #include "../util/data_structures/double_array.h"
@@ -40,20 +41,180 @@ using std::endl;
 using std::unique_ptr;
 using Search::Hit;
 
+typedef SeedArray::Entry::Value SeedValue;
+
+// Work items split into contiguous ranges, one per NUMA node. Threads claim the items of their own node first and
+// take over items of the other nodes once these are exhausted.
+struct WorkQueue {
+
+	// limits holds nodes+1 item boundaries
+	WorkQueue(vector<unsigned>&& limits):
+		limits_(std::move(limits)),
+		next_(limits_.size() - 1),
+		remote(0)
+	{
+		reset();
+	}
+
+	unsigned begin(size_t node) const {
+		return limits_[node];
+	}
+
+	unsigned end(size_t node) const {
+		return limits_[node + 1];
+	}
+
+	unsigned end() const {
+		return limits_.back();
+	}
+
+	// Returns the next item for a thread on the given node, or end() if there are none left.
+	unsigned next(size_t node) {
+		const size_t nodes = next_.size();
+		for (size_t i = 0; i < nodes; ++i) {
+			const size_t n = (node + i) % nodes;
+			if (next_[n].load(std::memory_order_relaxed) >= end(n))
+				continue;
+			const unsigned p = next_[n]++;
+			if (p < end(n)) {
+				if (i > 0)
+					++remote;
+				return p;
+			}
+		}
+		return end();
+	}
+
+	void reset() {
+		for (size_t i = 0; i < next_.size(); ++i)
+			next_[i] = limits_[i];
+	}
+
+private:
+
+	vector<unsigned> limits_;
+	vector<atomic<unsigned>> next_;
+
+public:
+
+	atomic<size_t> remote;
+
+};
+
+// Assigns contiguous parts of a seed partition range to NUMA nodes, balanced by the given size of the partitions.
+template<typename F>
+static vector<unsigned> partition_limits(const SeedPartitionRange& range, size_t nodes, F size) {
+	vector<unsigned> limits(nodes + 1);
+	size_t total = 0;
+	for (unsigned p = range.begin(); p < range.end(); ++p)
+		total += size(p);
+	size_t n = 0, sum = 0;
+	limits[0] = range.begin();
+	for (unsigned p = range.begin(); p < range.end(); ++p) {
+		sum += size(p);
+		while (n + 1 < nodes && sum * nodes >= total * (n + 1))
+			limits[++n] = p + 1;
+	}
+	while (n < nodes)
+		limits[++n] = range.end();
+	return limits;
+}
+
+// Index of the NUMA node that thread i out of n is assigned to.
+static size_t thread_node(size_t i, size_t n, size_t nodes) {
+	return i * nodes / n;
+}
+
+static void pin_to_node(size_t node) {
+	if (config.numa && numa_nodes().size() > 1)
+		pin_thread(numa_nodes()[node].cpus);
+}
+
+// Migrates the seed array memory of each node's partitions to that node.
+static void bind_partitions(const SeedArray& idx, const WorkQueue& queue, size_t nodes) {
+	for (size_t n = 0; n < nodes; ++n) {
+		const char* begin = nullptr, *end = nullptr;
+		for (unsigned p = queue.begin(n); p < queue.end(n); ++p) {
+			const char* b = (const char*)idx.begin(p), *e = (const char*)(idx.begin(p) + idx.size(p));
+			if (b != end) {
+				if (end != begin)
+					numa_bind(begin, end - begin, numa_nodes()[n].id);
+				begin = b;
+			}
+			end = e;
+		}
+		if (end != begin)
+			numa_bind(begin, end - begin, numa_nodes()[n].id);
+	}
+}
+
+template<typename F>
+static void run_workers(size_t nodes, F f) {
+	vector<std::thread> threads;
+	for (size_t i = 0; i < config.threads_; ++i)
+		threads.emplace_back([&f, i, nodes]() {
+			const size_t node = thread_node(i, config.threads_, nodes);
+			pin_to_node(node);
+			f(i, node);
+		});
+	for (auto& t : threads)
+		t.join();
+}
+
+// A slice of the join result of one seed partition: a run of consecutive seed groups, or a range of query seeds of
+// a single group. Query ranges start at multiples of the tile size so that stage 1 processes the same tiles.
+struct WorkUnit {
+	JoinIterator<SeedValue> it;
+	uint32_t groups, query_begin, query_end;
+};
+
+// Work units are cut so that hot partitions are spread over all threads instead of being processed by one.
+static const size_t UNITS_PER_THREAD = 16;
+
+static size_t partition_cost(DoubleArray<SeedValue>& query_hits, DoubleArray<SeedValue>& ref_hits) {
+	size_t cost = 0;
+	for (auto it = JoinIterator<SeedValue>(query_hits.begin(), ref_hits.begin()); it; ++it)
+		cost += (size_t)it.r->size() * it.s->size();
+	return cost;
+}
+
+static void split_partition(DoubleArray<SeedValue>& query_hits, DoubleArray<SeedValue>& ref_hits, size_t max_cost, vector<WorkUnit>& out) {
+	const size_t tile_size = config.tile_size;
+	auto it = JoinIterator<SeedValue>(query_hits.begin(), ref_hits.begin());
+	while (it) {
+		const size_t nq = it.r->size(), ns = it.s->size();
+		if (nq * ns > max_cost) {
+			const size_t step = std::max(max_cost / ns / tile_size, (size_t)1) * tile_size;
+			for (size_t i = 0; i < nq; i += step)
+				out.push_back({ it, 1, (uint32_t)i, (uint32_t)std::min(i + step, nq) });
+			++it;
+			continue;
+		}
+		WorkUnit unit{ it, 0, 0, UINT32_MAX };
+		size_t cost = 0;
+		while (it && (unit.groups == 0 || cost + (size_t)it.r->size() * it.s->size() <= max_cost)) {
+			cost += (size_t)it.r->size() * it.s->size();
+			++unit.groups;
+			++it;
+		}
+		out.push_back(unit);
+	}
+}
+
 void seed_join_worker(
 	SeedArray *query_seeds,
 	SeedArray *ref_seeds,
-	atomic<unsigned> *seedp,
-	const SeedPartitionRange *seedp_range,
-	DoubleArray<SeedArray::Entry::Value> *query_seed_hits,
-	DoubleArray<SeedArray::Entry::Value> *ref_seeds_hits)
+	WorkQueue *queue,
+	size_t node,
+	DoubleArray<SeedValue> *query_seed_hits,
+	DoubleArray<SeedValue> *ref_seeds_hits)
 {
 	unsigned p;
 	const unsigned bits = query_seeds->key_bits;
 	if (bits != ref_seeds->key_bits)
 		throw std::runtime_error("Joining seed arrays with different key lengths.");
-	while ((p = (*seedp)++) < seedp_range->end()) {
-		std::pair<DoubleArray<SeedArray::Entry::Value>, DoubleArray<SeedArray::Entry::Value>> join = hash_join(
+	while ((p = queue->next(node)) < queue->end()) {
+		std::pair<DoubleArray<SeedValue>, DoubleArray<SeedValue>> join = hash_join(
 			Relation<SeedArray::Entry>(query_seeds->begin(p), query_seeds->size(p)),
 			Relation<SeedArray::Entry>(ref_seeds->begin(p), ref_seeds->size(p)),
 			bits);
@@ -62,7 +223,7 @@ void seed_join_worker(
 	}
 }
 
-void search_worker(atomic<unsigned> *seedp, const SeedPartitionRange *seedp_range, unsigned shape, size_t thread_id, DoubleArray<SeedArray::Entry::Value> *query_seed_hits, DoubleArray<SeedArray::Entry::Value> *ref_seed_hits, const Search::Context *context, const Search::Config* cfg)
+void search_worker(WorkQueue *queue, const vector<WorkUnit> *units, size_t node, unsigned shape, size_t thread_id, const Search::Context *context, const Search::Config* cfg)
 {
 	unique_ptr<Writer<Hit>> writer;
 	if (config.global_ranking_targets)
@@ -72,22 +233,28 @@ void search_worker(atomic<unsigned> *seedp, const SeedPartitionRange *seedp_rang
 #ifdef __APPLE__
 	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {} });
 #else
-	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {}, {}, {} });
+	unique_ptr<Search::WorkSet> work_set(new Search::WorkSet{ *context, *cfg, shape, {}, writer.get(), {}, {}, {}, {}, {} });
 #endif
-	unsigned p;
-	while ((p = (*seedp)++) < seedp_range->end())
-		for (auto it = JoinIterator<SeedArray::Entry::Value>(query_seed_hits[p].begin(), ref_seed_hits[p].begin()); it; ++it)
-			Search::stage1(it.r->begin(), it.r->size(), it.s->begin(), it.s->size(), *work_set);
+	unsigned i;
+	while ((i = queue->next(node)) < queue->end()) {
+		const WorkUnit& u = (*units)[i];
+		auto it = u.it;
+		for (uint32_t j = 0; j < u.groups; ++j, ++it) {
+			const size_t query_end = std::min((size_t)u.query_end, (size_t)it.r->size());
+			Search::stage1(it.r->begin() + u.query_begin, query_end - u.query_begin, it.s->begin(), it.s->size(), *work_set);
+		}
+	}
 	statistics += work_set->stats;
 }
 
 void search_shape(unsigned sid, unsigned query_block, unsigned query_iteration, char *query_buffer, char *ref_buffer, Search::Config& cfg, const HashedSeedSet* target_seeds)
 {
 	Partition<unsigned> p(Const::seedp, cfg.index_chunks);
-	DoubleArray<SeedArray::Entry::Value> query_seed_hits[Const::seedp], ref_seed_hits[Const::seedp];
+	DoubleArray<SeedValue> query_seed_hits[Const::seedp], ref_seed_hits[Const::seedp];
 	log_rss();
 	SequenceSet& ref_seqs = cfg.target->seqs(), query_seqs = cfg.query->seqs();
 	const Partitioned_histogram& ref_hst = cfg.target->hst(), query_hst = cfg.query->hst();
+	const size_t nodes = config.numa ? std::max(numa_nodes().size(), (size_t)1) : 1;
 
 	for (unsigned chunk = 0; chunk < p.parts; ++chunk) {
 		message_stream << "Processing query block " << query_block + 1;
@@ -101,33 +268,51 @@ void search_shape(unsigned sid, unsigned query_block, unsigned query_iteration,
 		const SeedPartitionRange range(p.begin(chunk), p.end(chunk));
 		current_range = range;
 
-		task_timer timer("Building reference seed array", true);
-		SeedArray *ref_idx;
-		if (query_seeds_bitset.get())
-			ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, query_seeds_bitset.get(), cfg.seed_encoding, nullptr);
-		else if (query_seeds_hashed.get())
-			ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, query_seeds_hashed.get(), cfg.seed_encoding, nullptr);
-			//ref_idx = new SeedArray(ref_seqs, sid, range, query_seeds_hashed.get(), true);
-		else
-			ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, &no_filter, cfg.seed_encoding, nullptr);
-
-		timer.go("Building query seed array");
-		SeedArray* query_idx;
-		if (target_seeds)
-			query_idx = new SeedArray(query_seqs, sid, range, target_seeds, cfg.seed_encoding, nullptr);
-		else
-			query_idx = new SeedArray(query_seqs, sid, query_hst.get(sid), range, query_hst.partition(), query_buffer, &no_filter, cfg.seed_encoding, cfg.query_skip.get());
-		timer.finish();
-
-		log_stream << "Indexed query seeds = " << query_idx->size() << '/' << query_seqs.letters() << ", reference seeds = " << ref_idx->size() << '/' << ref_seqs.letters() << endl;
-
-		timer.go("Computing hash join");
-		atomic<unsigned> seedp(range.begin());
-		vector<std::thread> threads;
-		for (size_t i = 0; i < config.threads_; ++i)
-			threads.emplace_back(seed_join_worker, query_idx, ref_idx, &seedp, &range, query_seed_hits, ref_seed_hits);
-		for (auto &t : threads)
-			t.join();
+		task_timer timer;
+		SeedArray *ref_idx = nullptr, *query_idx = nullptr;
+		vector<unsigned> limits;
+		if (query_seeds_ctg.get()) {
+			timer.go("Computing contiguous seed join");
+			query_seeds_ctg->join(ref_seqs, range, query_seed_hits, ref_seed_hits);
+			limits = partition_limits(range, nodes, [&](unsigned p) { return query_seed_hits[p].size() + ref_seed_hits[p].size(); });
+			timer.finish();
+		}
+		else {
+			timer.go("Building reference seed array");
+			if (query_seeds_hashed.get())
+				ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, query_seeds_hashed.get(), cfg.seed_encoding, nullptr);
+				//ref_idx = new SeedArray(ref_seqs, sid, range, query_seeds_hashed.get(), true);
+			else if (cfg.seed_window) {
+				const SyncmerFilter filter(cfg.seed_window);
+				ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, &filter, cfg.seed_encoding, nullptr);
+			}
+			else
+				ref_idx = new SeedArray(ref_seqs, sid, ref_hst.get(sid), range, ref_hst.partition(), ref_buffer, &no_filter, cfg.seed_encoding, nullptr);
+
+			timer.go("Building query seed array");
+			if (target_seeds)
+				query_idx = new SeedArray(query_seqs, sid, range, target_seeds, cfg.seed_encoding, nullptr);
+			else
+				query_idx = new SeedArray(query_seqs, sid, query_hst.get(sid), range, query_hst.partition(), query_buffer, &no_filter, cfg.seed_encoding, cfg.query_skip.get());
+			timer.finish();
+
+			log_stream << "Indexed query seeds = " << query_idx->size() << '/' << query_seqs.letters() << ", reference seeds = " << ref_idx->size() << '/' << ref_seqs.letters() << endl;
+			limits = partition_limits(range, nodes, [&](unsigned p) { return query_idx->size(p) + ref_idx->size(p); });
+		}
+
+		WorkQueue queue(std::move(limits));
+		if (ref_idx) {
+			if (nodes > 1) {
+				timer.go("Binding seed arrays to NUMA nodes");
+				bind_partitions(*query_idx, queue, nodes);
+				bind_partitions(*ref_idx, queue, nodes);
+			}
+
+			timer.go("Computing hash join");
+			run_workers(nodes, [&](size_t, size_t node) {
+				seed_join_worker(query_idx, ref_idx, &queue, node, query_seed_hits, ref_seed_hits);
+			});
+		}
 
 		timer.go("Building seed filter");
 		frequent_seeds.build(sid, range, query_seed_hits, ref_seed_hits, cfg);
@@ -141,13 +326,45 @@ void search_shape(unsigned sid, unsigned query_block, unsigned query_iteration,
 			score_matrix.rawscore(config.short_query_ungapped_bitscore)
 		};
 
+		timer.go("Computing work units");
+		vector<size_t> cost(Const::seedp);
+		queue.reset();
+		run_workers(nodes, [&](size_t, size_t node) {
+			unsigned p;
+			while ((p = queue.next(node)) < queue.end())
+				cost[p] = partition_cost(query_seed_hits[p], ref_seed_hits[p]);
+		});
+		size_t total_cost = 0;
+		for (unsigned p = range.begin(); p < range.end(); ++p)
+			total_cost += cost[p];
+		const size_t max_cost = std::max(total_cost / (config.threads_ * UNITS_PER_THREAD), config.tile_size * config.tile_size);
+		vector<vector<WorkUnit>> partition_units(Const::seedp);
+		queue.reset();
+		run_workers(nodes, [&](size_t, size_t node) {
+			unsigned p;
+			while ((p = queue.next(node)) < queue.end())
+				split_partition(query_seed_hits[p], ref_seed_hits[p], max_cost, partition_units[p]);
+		});
+		vector<WorkUnit> units;
+		vector<unsigned> unit_limits;
+		for (size_t n = 0; n < nodes; ++n) {
+			unit_limits.push_back((unsigned)units.size());
+			for (unsigned p = queue.begin(n); p < queue.end(n); ++p)
+				units.insert(units.end(), partition_units[p].begin(), partition_units[p].end());
+		}
+		unit_limits.push_back((unsigned)units.size());
+		vector<vector<WorkUnit>>().swap(partition_units);
+		const size_t partition_remote = queue.remote;
+		WorkQueue unit_queue(std::move(unit_limits));
+
 		timer.go("Searching alignments");
-		seedp = range.begin();
-		threads.clear();
-		for (size_t i = 0; i < config.threads_; ++i)
-			threads.emplace_back(search_worker, &seedp, &range, sid, i, query_seed_hits, ref_seed_hits, context, &cfg);
-		for (auto &t : threads)
-			t.join();
+		run_workers(nodes, [&](size_t i, size_t node) {
+			search_worker(&unit_queue, &units, node, sid, i, context, &cfg);
+		});
+		log_stream << "Seed hit work units = " << units.size() << ", maximum cost = " << max_cost << ", total cost = " << total_cost << endl;
+		if (nodes > 1)
+			log_stream << "Work items processed on a remote NUMA node: partitions " << partition_remote << '/' << 3 * range.size()
+				<< ", work units " << unit_queue.remote << '/' << units.size() << endl;
 
 		delete ref_idx;
 		delete query_idx;
@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ****/
 
 #include <limits.h>
+#include <random>
+#include <chrono>
 #include "search.h"
 #include "../data/queries.h"
 #include "../data/reference.h"
@@ -158,6 +160,11 @@ static void FLATTEN search_tile(
 }
 
 typedef vector<FingerPrint, Util::Memory::AlignmentAllocator<FingerPrint, 16>> Container;
+typedef Bitsliced_finger_print_48 PackedFingerPrint;
+
+// Bit-sliced fingerprints are more expensive to build, so they are only used for seed groups where each fingerprint
+// takes part in enough comparisons.
+static const size_t PACKED_MIN_GROUP = 8, PACKED_MIN_PAIRS = 512;
 
 static void all_vs_all(const FingerPrint* a, uint32_t na, const FingerPrint* b, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
 	for (uint32_t i = 0; i < na; ++i) {
@@ -178,18 +185,114 @@ static void load_fps(const SeedArray::Entry::Value* p, size_t n, Container& v, c
 		v.emplace_back(seqs.data(*p));
 }
 
+// Fingerprints are stored plane by plane: plane k of fingerprint i is at v[k * n + i].
+static void load_fps(const SeedArray::Entry::Value* p, size_t n, vector<uint64_t>& v, const SequenceSet& seqs)
+{
+	v.resize(n * PackedFingerPrint::PLANES);
+	for (size_t i = 0; i < n; ++i) {
+		const PackedFingerPrint f(seqs.data(p[i]));
+		for (int k = 0; k < PackedFingerPrint::PLANES; ++k)
+			v[k * n + i] = f.plane[k];
+	}
+}
+
+#ifdef __AVX2__
+static inline __m256i popcount_epi64(__m256i x) {
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4),
+		low_mask = _mm256_set1_epi8(0x0f);
+	const __m256i lo = _mm256_and_si256(x, low_mask), hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask),
+		cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+	return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+#endif
+
+// a and b point to the first fingerprint of the tile within plane 0, the planes are a_stride and b_stride words apart.
+static void all_vs_all(const uint64_t* a, size_t a_stride, uint32_t na, const uint64_t* b, size_t b_stride, uint32_t nb, FlatArray<uint32_t>& out, unsigned hamming_filter_id) {
+	constexpr int PLANES = PackedFingerPrint::PLANES;
+	for (uint32_t i = 0; i < na; ++i) {
+		out.next();
+		uint32_t j = 0;
+#ifdef __AVX2__
+		__m256i q[PLANES];
+		for (int k = 0; k < PLANES; ++k)
+			q[k] = _mm256_set1_epi64x((long long)a[k * a_stride + i]);
+		const __m256i position_mask = _mm256_set1_epi64x((long long)PackedFingerPrint::POSITION_MASK),
+			threshold = _mm256_set1_epi64x((long long)hamming_filter_id - 1);
+		for (; j + 4 <= nb; j += 4) {
+			__m256i diff = _mm256_xor_si256(q[0], _mm256_loadu_si256((const __m256i*)(b + j)));
+			for (int k = 1; k < PLANES; ++k)
+				diff = _mm256_or_si256(diff, _mm256_xor_si256(q[k], _mm256_loadu_si256((const __m256i*)(b + k * b_stride + j))));
+			const __m256i n = popcount_epi64(_mm256_andnot_si256(diff, position_mask));
+			unsigned mask = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(n, threshold)));
+			while (mask) {
+				out.push_back(j + ctz(mask));
+				mask &= mask - 1;
+			}
+		}
+#endif
+		for (; j < nb; ++j)
+			if (PackedFingerPrint::match(a + i, a_stride, b + j, b_stride) >= hamming_filter_id)
+				out.push_back(j);
+	}
+}
+
+double tile_throughput(size_t n, size_t tile_size, unsigned hamming_filter_id)
+{
+	constexpr size_t STRIDE = 64;
+	constexpr double MIN_TIME = 0.05;
+	std::mt19937 rng(0);
+	vector<Letter> seq(n * STRIDE);
+	for (Letter& l : seq)
+		l = Letter(rng() % 20);
+	vector<uint64_t> fps(n * PackedFingerPrint::PLANES);
+	for (size_t i = 0; i < n; ++i) {
+		const PackedFingerPrint f(seq.data() + i * STRIDE + 16);
+		for (int k = 0; k < PackedFingerPrint::PLANES; ++k)
+			fps[k * n + i] = f.plane[k];
+	}
+	FlatArray<uint32_t> hits;
+	size_t pairs = 0;
+	double elapsed;
+	const auto begin = std::chrono::high_resolution_clock::now();
+	do {
+		for (size_t i = 0; i < n; i += tile_size)
+			for (size_t j = 0; j < n; j += tile_size) {
+				hits.clear();
+				all_vs_all(fps.data() + i, n, (uint32_t)std::min(tile_size, n - i), fps.data() + j, n, (uint32_t)std::min(tile_size, n - j), hits, hamming_filter_id);
+			}
+		pairs += n * n;
+		elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+	} while (elapsed < MIN_TIME);
+	return pairs / elapsed;
+}
+
 void FLATTEN stage1(const SeedArray::Entry::Value* q, size_t nq, const SeedArray::Entry::Value* s, size_t ns, WorkSet& work_set)
 {
 #ifdef __APPLE__
 	thread_local Container vq, vs;
+	thread_local vector<uint64_t> pq, ps;
 #else
 	Container& vq = work_set.vq, &vs = work_set.vs;
+	vector<uint64_t>& pq = work_set.pq, &ps = work_set.ps;
 #endif
 	work_set.stats.inc(Statistics::SEED_HITS, nq * ns);
+	const size_t tile_size = config.tile_size;
+
+	if (std::min(nq, ns) >= PACKED_MIN_GROUP && nq * ns >= PACKED_MIN_PAIRS) {
+		load_fps(q, nq, pq, work_set.cfg.query->seqs());
+		load_fps(s, ns, ps, work_set.cfg.target->seqs());
+		for (size_t i = 0; i < nq; i += tile_size) {
+			for (size_t j = 0; j < ns; j += tile_size) {
+				work_set.hits.clear();
+				all_vs_all(pq.data() + i, nq, (uint32_t)std::min(tile_size, nq - i), ps.data() + j, ns, (uint32_t)std::min(tile_size, ns - j), work_set.hits, work_set.cfg.hamming_filter_id);
+				search_tile(work_set.hits, i, j, q, s, work_set);
+			}
+		}
+		return;
+	}
+
 	load_fps(q, nq, vq, work_set.cfg.query->seqs());
 	load_fps(s, ns, vs, work_set.cfg.target->seqs());
-
-	const size_t tile_size = config.tile_size;
 	for (size_t i = 0; i < vq.size(); i += tile_size) {
 		for (size_t j = 0; j < vs.size(); j += tile_size) {
 			work_set.hits.clear();
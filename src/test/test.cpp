@@ -48,23 +48,39 @@ using std::shared_ptr;
 
 namespace Test {
 
-size_t run_testcase(size_t i, shared_ptr<DatabaseFile> &db, shared_ptr<list<TextInputFile>>& query_file, size_t max_width, bool bootstrap, bool log, bool to_cout) {
+// Back-translates the test proteins with one codon per amino acid and deletes a nucleotide in the middle of each
+// sequence, so that the blastx cases have a frameshift to align across.
+static void write_dna_queries(OutputFile& out) {
+	static const char* codons[] = { "GCT", "CGT", "AAT", "GAT", "TGT", "CAA", "GAA", "GGT", "CAT", "ATT", "CTG", "AAA", "ATG", "TTT", "CCG", "TCT", "ACC", "TGG", "TAT", "GTT" };
+	for (size_t i = 0; i < seqs.size(); ++i) {
+		const vector<Letter> seq = Sequence::from_string(seqs[i].second.c_str());
+		string dna;
+		for (Letter l : seq)
+			dna += l < 20 ? codons[(int)l] : "NNN";
+		dna.erase(dna.length() / 2, 1);
+		Util::Seq::format(Sequence::from_string(dna.c_str(), nucleotide_traits), seqs[i].first.c_str(), nullptr, out, "fasta", nucleotide_traits);
+	}
+}
+
+size_t run_testcase(size_t i, shared_ptr<DatabaseFile> &db, shared_ptr<list<TextInputFile>>& query_file, shared_ptr<list<TextInputFile>>& dna_query_file, size_t max_width, bool bootstrap, bool log, bool to_cout) {
 	vector<string> args = tokenize(test_cases[i].command_line, " ");
 	args.emplace(args.begin(), "diamond");
 	if (log)
 		args.push_back("--log");
+	input_value_traits = amino_acid_traits;
 	config = Config((int)args.size(), charp_array(args.begin(), args.end()).data(), false);
 	statistics.reset();
-	query_file->front().rewind();
+	shared_ptr<list<TextInputFile>>& queries = config.command == Config::blastx ? dna_query_file : query_file;
+	queries->front().rewind();
 
 	if (to_cout) {
-		Search::run(db, query_file);
+		Search::run(db, queries);
 		return 0;
 	}
 	
 	shared_ptr<TempFile> output_file(new TempFile(!bootstrap));
 
-	Search::run(db, query_file, output_file);
+	Search::run(db, queries, output_file);
 
 	InputFile out_in(*output_file);
 	uint64_t hash = out_in.hash();
@@ -96,6 +112,10 @@ int run() {
 		Util::Seq::format(Sequence::from_string(seqs[i].second.c_str()), seqs[i].first.c_str(), nullptr, proteins, "fasta", amino_acid_traits);
 	shared_ptr<list<TextInputFile>> query_file(new list<TextInputFile>);
 	query_file->emplace_back(proteins);
+	TempFile dna;
+	write_dna_queries(dna);
+	shared_ptr<list<TextInputFile>> dna_query_file(new list<TextInputFile>);
+	dna_query_file->emplace_back(dna);
 	timer.finish();
 
 	config.command = Config::makedb;
@@ -107,11 +127,12 @@ int run() {
 		max_width = std::accumulate(test_cases.begin(), test_cases.end(), (size_t)0, [](size_t l, const TestCase& t) { return std::max(l, strlen(t.desc)); });
 	size_t passed = 0;
 	for (size_t i = 0; i < n; ++i)
-		passed += run_testcase(i, db, query_file, max_width, bootstrap, log, to_cout);
+		passed += run_testcase(i, db, query_file, dna_query_file, max_width, bootstrap, log, to_cout);
 
 	cout << endl << "#Test cases passed: " << passed << '/' << n << endl; // << endl;
 	
 	query_file->front().close_and_delete();
+	dna_query_file->front().close_and_delete();
 	db->close();
 	delete db_file;
 	return passed == n ? 0 : 1;
@@ -44,7 +44,11 @@ const vector<TestCase> test_cases = {
 { "blastp (blosum50)", "blastp --matrix blosum50 -p4"},
 { "blastp (pairwise format)", "blastp -c1 -f0 -p4" },
 { "blastp (XML format)", "blastp -c1 -f xml -p4" },
-{ "blastp (PAF format)", "blastp -c1 -f paf -p1" }
+{ "blastp (PAF format)", "blastp -c1 -f paf -p1" },
+{ "blastp (subsample-seeds)", "blastp --fast --subsample-seeds -c1 -p4" },
+{ "blastp (ctg)", "blastp -c1 -p4 --algo ctg" },
+{ "blastx (frameshift)", "blastx -F 15 -c1 -p4" },
+{ "blastx (frameshift checkpoint)", "blastx -F 15 -c1 -p4 --traceback-checkpoint-dp 0" }
 };
 
 const vector<uint64_t> ref_hashes = {
@@ -68,6 +72,10 @@ const vector<uint64_t> ref_hashes = {
 0xc43258834622128e,
 0xc46789eaf0eb46ea,
 0x58c74e056adf9a71,
+0xdcefdecc5c0afed4,
+0xe4641f2aa96dd27b,
+0xd7ad679361206294,
+0xd7ad679361206294,
 };
 
 }
\ No newline at end of file
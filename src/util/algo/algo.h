@@ -3,6 +3,7 @@
 #include <vector>
 #include <stddef.h>
 #include "partition.h"
+#include "../data_structures/flat_array.h"
 
 namespace Util { namespace Algo {
 
@@ -13,7 +14,10 @@ struct Edge {
 	}
 };
 
-std::vector<int> greedy_vertex_cover(std::vector<std::vector<int>> &neighbors);
+// With rounds set, the centroids are selected in parallel rounds of local maxima, which is deterministic but may differ
+// from the serial greedy order.
+std::vector<int> greedy_vertex_cover(std::vector<std::vector<int>> &neighbors, size_t threads, bool rounds = false);
+std::vector<int> greedy_vertex_cover(const FlatArray<int> &neighbors, size_t threads, bool rounds = false);
 
 template<typename It, typename Out>
 size_t merge_capped(It i0, const It i1, It j0, const It j1, const size_t cap, Out out) {
@@ -2,12 +2,15 @@
 #include <limits.h>
 #include <math.h>
 #include <algorithm>
+#include <thread>
+#include <exception>
 #include "edge_vec.h"
 #include "../../util/io/text_input_file.h"
 #include "../../util/string/tokenizer.h"
 #include "../algo/merge_sort.h"
 #include "../../basic/config.h"
 #include "../io/temp_file.h"
+#include "partition.h"
 
 using std::string;
 using std::array;
@@ -19,6 +22,49 @@ DistType dist_type() {
 	return config.upgma_dist == "bitscore" ? DistType::BITSCORE : DistType::EVALUE;
 }
 
+static const size_t PARSE_BATCH = 65536;
+
+struct ParsedEdge {
+	string query, target;
+	double dist;
+};
+
+// Tokenizes a batch of input lines in parallel. Node indices are assigned by the caller in input order.
+static void parse_lines(const vector<string>& lines, vector<ParsedEdge>& out, DistType dt) {
+	out.resize(lines.size());
+	const Partition<size_t> p(lines.size(), std::max((size_t)config.threads_, (size_t)1));
+	vector<std::exception_ptr> error(p.parts);
+	auto worker = [&](size_t part) {
+		try {
+			double evalue, bitscore;
+			int qlen, slen;
+			for (size_t i = p.begin(part); i < p.end(part); ++i) {
+				String::Tokenizer t(lines[i], "\t");
+				t >> out[i].query >> out[i].target;
+				if (dt == DistType::BITSCORE) {
+					t >> bitscore >> qlen >> slen;
+					out[i].dist = -bitscore / std::max(qlen, slen);
+				}
+				else {
+					t >> evalue;
+					out[i].dist = evalue;
+				}
+			}
+		}
+		catch (...) {
+			error[part] = std::current_exception();
+		}
+	};
+	vector<std::thread> threads;
+	for (size_t i = 0; i < p.parts; ++i)
+		threads.emplace_back(worker, i);
+	for (auto& t : threads)
+		t.join();
+	for (const std::exception_ptr& e : error)
+		if (e)
+			std::rethrow_exception(e);
+}
+
 EdgeVec::EdgeVec(const char *file):
 	current_bucket_(-1),
 	i_(0),
@@ -61,31 +107,36 @@ EdgeVec::EdgeVec(const char *file):
 	}
 	else {
 		TextInputFile in(file);
-		string query, target;
-		double evalue, bitscore;
-		int qlen, slen;
-		while (in.getline(), !in.eof()) {
-			String::Tokenizer t(in.line, "\t");
-			t >> query >> target;
-			if (dt == DistType::BITSCORE)
-				t >> bitscore >> qlen >> slen;
-			else
-				t >> evalue;
-			auto i = acc2idx.emplace(query, (int)acc2idx.size()), j = acc2idx.emplace(target, (int)acc2idx.size());
-			if (i.second)
-				idx2acc[i.first->second] = i.first->first;
-			if (j.second)
-				idx2acc[j.first->second] = j.first->first;
-			if (i.first->second < j.first->second) {
-				const double dist = (dt == DistType::BITSCORE) ? -bitscore / std::max(qlen, slen) : evalue;
-				const int b = bucket(dist, dt);
-				//std::cout << b << std::endl;
-				buffers[b].push_back({ i.first->second, j.first->second, dist });
-				if (buffers[b].size() == 4096) {
-					temp_files[b].write(buffers[b].data(), buffers[b].size());
-					buffers[b].clear();
+		vector<string> lines;
+		vector<ParsedEdge> edges;
+		lines.reserve(PARSE_BATCH);
+		bool eof = false;
+		while (!eof) {
+			lines.clear();
+			while (lines.size() < PARSE_BATCH) {
+				in.getline();
+				if (in.eof()) {
+					eof = true;
+					break;
+				}
+				lines.push_back(in.line);
+			}
+			parse_lines(lines, edges, dt);
+			for (const ParsedEdge& e : edges) {
+				auto i = acc2idx.emplace(e.query, (int)acc2idx.size()), j = acc2idx.emplace(e.target, (int)acc2idx.size());
+				if (i.second)
+					idx2acc[i.first->second] = i.first->first;
+				if (j.second)
+					idx2acc[j.first->second] = j.first->first;
+				if (i.first->second < j.first->second) {
+					const int b = bucket(e.dist, dt);
+					buffers[b].push_back({ i.first->second, j.first->second, e.dist });
+					if (buffers[b].size() == 4096) {
+						temp_files[b].write(buffers[b].data(), buffers[b].size());
+						buffers[b].clear();
+					}
+					++size_;
 				}
-				++size_;
 			}
 		}
 		in.close();
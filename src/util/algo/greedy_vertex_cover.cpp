@@ -1,67 +1,271 @@
 #include <algorithm>
 #include <iterator>
-#include <map>
+#include <atomic>
+#include <thread>
+#include <numeric>
 #include "algo.h"
 
 using namespace std;
 
 namespace Util { namespace Algo {
 
+// Bucket queue of the unassigned nodes of one connected component, keyed by their count of unassigned neighbors.
+// Each bucket is a doubly linked list that is appended at the tail, so that popping the tail of the highest bucket
+// selects the same node as the rbegin() of a multimap<count, node> with the same insertion history.
+struct BucketQueue {
+
+	BucketQueue(vector<int>& count, vector<int>& prev, vector<int>& next) :
+		top_(-1),
+		count_(count),
+		prev_(prev),
+		next_(next)
+	{}
+
+	void init(int max_count) {
+		head_.assign(max_count + 1, -1);
+		tail_.assign(max_count + 1, -1);
+		top_ = max_count;
+	}
+
+	void push(int i, int count) {
+		count_[i] = count;
+		prev_[i] = tail_[count];
+		next_[i] = -1;
+		if (tail_[count] >= 0)
+			next_[tail_[count]] = i;
+		else
+			head_[count] = i;
+		tail_[count] = i;
+	}
+
+	void erase(int i) {
+		const int c = count_[i];
+		if (prev_[i] >= 0)
+			next_[prev_[i]] = next_[i];
+		else
+			head_[c] = next_[i];
+		if (next_[i] >= 0)
+			prev_[next_[i]] = prev_[i];
+		else
+			tail_[c] = prev_[i];
+	}
+
+	void decrement(int i) {
+		erase(i);
+		push(i, count_[i] - 1);
+	}
+
+	// counts never increase, so the top bucket only moves down
+	int back() {
+		while (top_ >= 0 && tail_[top_] < 0)
+			--top_;
+		return top_ >= 0 ? tail_[top_] : -1;
+	}
+
+private:
+
+	int top_;
+	vector<int> head_, tail_;
+	vector<int>& count_, &prev_, &next_;
+
+};
+
 struct GreedyVertexCover {
 
-	GreedyVertexCover(vector<vector<int>> &neighbors) :
-		reverse_neighbors(neighbors.size()) {
+	// neighbors needs to be symmetric and each list sorted
+	GreedyVertexCover(const FlatArray<int> &neighbors, size_t threads, bool rounds) :
+		neighbors(neighbors)
+	{
 		const int n = (int)neighbors.size();
 		centroid.insert(centroid.begin(), n, -1);
-		for (int i = 0; i < n; ++i) {
-			for (int j : neighbors[i])
-				reverse_neighbors[j].push_back(i);
+		if (rounds) {
+			cover_rounds(std::max(threads, (size_t)1));
+			return;
 		}
+		count.resize(n);
+		prev.resize(n);
+		next.resize(n);
+		find_components();
 
-		vector<int> merged;
-		for (int i = 0; i < n; ++i) {
-			std::sort(neighbors[i].begin(), neighbors[i].end());
-			std::sort(reverse_neighbors[i].begin(), reverse_neighbors[i].end());
-			merged.clear();
-			std::set_union(neighbors[i].begin(), neighbors[i].end(), reverse_neighbors[i].begin(), reverse_neighbors[i].end(), std::back_inserter(merged));
-			neighbors[i] = merged;
-		}
+		// Components do not interact in the greedy selection, so processing them independently gives the same
+		// result as a single global queue.
+		atomic<size_t> next_component(0);
+		auto worker = [&]() {
+			BucketQueue queue(count, prev, next);
+			size_t c;
+			while ((c = next_component.fetch_add(1, memory_order_relaxed)) < components.size())
+				cover_component(components.cbegin(c), components.cend(c), queue);
+		};
+		vector<thread> t;
+		for (size_t i = 0; i < std::min(std::max(threads, (size_t)1), components.size()); ++i)
+			t.emplace_back(worker);
+		for (auto& i : t)
+			i.join();
+	}
 
-		its.reserve(n);
+	// Lists the nodes of the connected components with more than one node, in ascending order within each component.
+	// Isolated nodes are their own centroid.
+	void find_components() {
+		const int n = (int)neighbors.size();
+		vector<int> label(n, -1), stack, members;
+		int component_count = 0;
 		for (int i = 0; i < n; ++i) {
-			its.push_back(count_to_idx.insert(make_pair((int)neighbors[i].size(), i)));
+			if (label[i] >= 0)
+				continue;
+			if (neighbors.count(i) == 0 || (neighbors.count(i) == 1 && *neighbors.cbegin(i) == i)) {
+				centroid[i] = i;
+				continue;
+			}
+			members.clear();
+			stack.push_back(i);
+			label[i] = component_count;
+			while (!stack.empty()) {
+				const int j = stack.back();
+				stack.pop_back();
+				members.push_back(j);
+				for (auto k = neighbors.cbegin(j); k < neighbors.cend(j); ++k)
+					if (label[*k] < 0) {
+						label[*k] = component_count;
+						stack.push_back(*k);
+					}
+			}
+			std::sort(members.begin(), members.end());
+			components.push_back(members.cbegin(), members.cend());
+			++component_count;
 		}
+	}
 
-		while (!count_to_idx.empty()) {
-			const int i = count_to_idx.rbegin()->second;
-			assign_centroid(i, i, neighbors);
-			for (int j : neighbors[i])
-				if (centroid[j] == -1)
-					assign_centroid(j, i, neighbors);
+	void cover_component(FlatArray<int>::ConstIterator begin, FlatArray<int>::ConstIterator end, BucketQueue& queue) {
+		int max_count = 0;
+		for (auto i = begin; i < end; ++i)
+			max_count = std::max(max_count, (int)neighbors.count(*i));
+		queue.init(max_count);
+		for (auto i = begin; i < end; ++i)
+			queue.push(*i, (int)neighbors.count(*i));
+
+		int i;
+		while ((i = queue.back()) >= 0) {
+			assign_centroid(i, i, queue);
+			for (auto j = neighbors.cbegin(i); j < neighbors.cend(i); ++j)
+				if (centroid[*j] == -1)
+					assign_centroid(*j, i, queue);
 		}
 	}
 
-	void assign_centroid(int i, int c, const vector<vector<int>>& neighbors) {
+	void assign_centroid(int i, int c, BucketQueue& queue) {
 		centroid[i] = c;
-		count_to_idx.erase(its[i]);
-		for (int j : neighbors[i]) {
+		queue.erase(i);
+		for (auto it_j = neighbors.cbegin(i); it_j < neighbors.cend(i); ++it_j) {
+			const int j = *it_j;
 			if (centroid[j] >= 0)
 				continue;
-			auto it = count_to_idx.insert(make_pair(its[j]->first - 1, j));
-			count_to_idx.erase(its[j]);
-			its[j] = it;
+			queue.decrement(j);
 		}
 	}
 
-	vector<int> centroid;
-	multimap<int, int> count_to_idx;
-	vector<multimap<int, int>::iterator> its;
-	vector<vector<int>> reverse_neighbors;
+	template<typename F>
+	static void run_threads(size_t items, size_t threads, F f) {
+		const Partition<size_t> p(items, threads);
+		vector<thread> t;
+		for (size_t i = 0; i < p.parts; ++i)
+			t.emplace_back(f, p.begin(i), p.end(i));
+		for (auto& i : t)
+			i.join();
+	}
+
+	// In each round, every unassigned node whose (count, index) key is the largest among the unassigned nodes within
+	// distance 2 becomes a centroid and claims its unassigned neighbors. Two such nodes do not share an unassigned
+	// neighbor, so the claims of a round are independent and the result does not depend on the number of threads. The
+	// largest key of a round is always selected, so every round makes progress.
+	void cover_rounds(size_t threads) {
+		const int n = (int)neighbors.size();
+		vector<int64_t> key(n, -1), ball(n);
+		vector<int> open(n), selected;
+		std::iota(open.begin(), open.end(), 0);
+		while (!open.empty()) {
+			run_threads(open.size(), threads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const int v = open[i];
+					int64_t c = 0;
+					for (auto j = neighbors.cbegin(v); j < neighbors.cend(v); ++j)
+						if (centroid[*j] == -1 && *j != v)
+							++c;
+					key[v] = (c << 32) | v;
+				}
+			});
+			run_threads(open.size(), threads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const int v = open[i];
+					int64_t m = key[v];
+					for (auto j = neighbors.cbegin(v); j < neighbors.cend(v); ++j)
+						if (centroid[*j] == -1)
+							m = std::max(m, key[*j]);
+					ball[v] = m;
+				}
+			});
+			vector<char> is_max(open.size());
+			run_threads(open.size(), threads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const int v = open[i];
+					bool m = ball[v] == key[v];
+					for (auto j = neighbors.cbegin(v); m && j < neighbors.cend(v); ++j)
+						if (centroid[*j] == -1 && ball[*j] != key[v])
+							m = false;
+					is_max[i] = m;
+				}
+			});
+			selected.clear();
+			for (size_t i = 0; i < open.size(); ++i)
+				if (is_max[i])
+					selected.push_back(open[i]);
+			for (int v : selected)
+				centroid[v] = v;
+			run_threads(selected.size(), threads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const int v = selected[i];
+					for (auto j = neighbors.cbegin(v); j < neighbors.cend(v); ++j)
+						if (centroid[*j] == -1)
+							centroid[*j] = v;
+				}
+			});
+			open.erase(std::remove_if(open.begin(), open.end(), [this](int v) { return centroid[v] != -1; }), open.end());
+		}
+	}
+
+	const FlatArray<int>& neighbors;
+	vector<int> centroid, count, prev, next;
+	FlatArray<int> components;
 
 };
 
-vector<int> greedy_vertex_cover(vector<vector<int>> &neighbors) {
-	return GreedyVertexCover(neighbors).centroid;
+static FlatArray<int> symmetrize(vector<vector<int>> &neighbors) {
+	const int n = (int)neighbors.size();
+	vector<vector<int>> reverse_neighbors(n);
+	for (int i = 0; i < n; ++i) {
+		for (int j : neighbors[i])
+			reverse_neighbors[j].push_back(i);
+	}
+
+	FlatArray<int> r;
+	vector<int> merged;
+	for (int i = 0; i < n; ++i) {
+		std::sort(neighbors[i].begin(), neighbors[i].end());
+		std::sort(reverse_neighbors[i].begin(), reverse_neighbors[i].end());
+		merged.clear();
+		std::set_union(neighbors[i].begin(), neighbors[i].end(), reverse_neighbors[i].begin(), reverse_neighbors[i].end(), std::back_inserter(merged));
+		r.push_back(merged.cbegin(), merged.cend());
+		vector<int>().swap(reverse_neighbors[i]);
+	}
+	return r;
+}
+
+vector<int> greedy_vertex_cover(vector<vector<int>> &neighbors, size_t threads, bool rounds) {
+	const FlatArray<int> adjacency = symmetrize(neighbors);
+	return GreedyVertexCover(adjacency, threads, rounds).centroid;
+}
+
+vector<int> greedy_vertex_cover(const FlatArray<int> &neighbors, size_t threads, bool rounds) {
+	return GreedyVertexCover(neighbors, threads, rounds).centroid;
 }
 
-}}
\ No newline at end of file
+}}
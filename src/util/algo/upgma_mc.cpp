@@ -10,12 +10,14 @@
 #include <stdlib.h>
 #include <iomanip>
 #include <unordered_map>
+#include <thread>
 #include "../io/text_input_file.h"
 #include "../../basic/config.h"
 #include "../string/tokenizer.h"
 #include "../log_stream.h"
 #include "../../lib/MemoryPool/MemoryPool.h"
 #include "edge_vec.h"
+#include "partition.h"
 
 using std::string;
 using std::list;
@@ -64,14 +66,39 @@ struct Edge {
 typedef list<Edge, MemoryPool<Edge>> EdgeList;
 typedef EdgeList::iterator EdgePtr;
 
+// The bounds and nodes of an edge do not change while it is queued, so they are stored in the queue entry to avoid
+// dereferencing the list node for every heap comparison and validity check.
+struct QueueEntry {
+	QueueEntry(EdgePtr e):
+		l(e->l),
+		u(e->u),
+		n1(e->n1),
+		n2(e->n2),
+		e(e)
+	{}
+	double l, u;
+	int n1, n2;
+	EdgePtr e;
+};
+
 struct CmpEdge {
-	bool operator()(const EdgePtr& e, const EdgePtr &f) const {
-		//return e->l > f->l || (e->l == f->l && (e->n1 > f->n1 || (e->n1 == f->n1 && e->n2 > f->n2)));
-		return e->l > f->l || (e->l == f->l && e->u > f->u);
+	bool operator()(const QueueEntry& e, const QueueEntry &f) const {
+		//return e.l > f.l || (e.l == f.l && (e.n1 > f.n1 || (e.n1 == f.n1 && e.n2 > f.n2)));
+		return e.l > f.l || (e.l == f.l && e.u > f.u);
 	}
 };
 
-typedef std::priority_queue<EdgePtr, vector<EdgePtr>, CmpEdge> Queue;
+typedef std::priority_queue<QueueEntry, vector<QueueEntry>, CmpEdge> Queue;
+
+template<typename F>
+static void run_threads(size_t items, F f) {
+	const Partition<size_t> p(items, std::max((size_t)config.threads_, (size_t)1));
+	vector<std::thread> t;
+	for (size_t i = 0; i < p.parts; ++i)
+		t.emplace_back(f, p.begin(i), p.end(i));
+	for (auto& i : t)
+		i.join();
+}
 
 void erase(EdgePtr &e, EdgeList &edges) {
 	++e->deleted;
@@ -112,6 +139,10 @@ bool valid(const EdgePtr &e, const vector<Node> &nodes) {
 	return nodes[e->n1].root() && nodes[e->n2].root();
 }
 
+bool valid(const QueueEntry &e, const vector<Node> &nodes) {
+	return nodes[e.n1].root() && nodes[e.n2].root();
+}
+
 void merge_nodes(int n1,
 	int n2,
 	vector<Node> &nodes,
@@ -229,19 +260,39 @@ double load_edges(EdgeVec& all_edges, EdgeList &edges, vector<Node> &nodes, Queu
 	message_stream << "Recomputing bounds, building edge vector and neighborhood..." << endl;
 	vector<EdgePtr> edge_vec;
 	edge_vec.reserve(edges.size());
-	for (EdgeList::iterator i = edges.begin(); i != edges.end(); ++i) {
-		i->set_bounds(lambda, max_dist, (double)nodes[i->n1].size * (double)nodes[i->n2].size);
+	for (EdgeList::iterator i = edges.begin(); i != edges.end(); ++i)
 		edge_vec.push_back(i);
-		nodes[i->n1].neighbors.push_back(i);
-		nodes[i->n2].neighbors.push_back(i);
+	run_threads(edge_vec.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			edge_vec[i]->set_bounds(lambda, max_dist, (double)nodes[edge_vec[i]->n1].size * (double)nodes[edge_vec[i]->n2].size);
+	});
+	// the counting pass assigns each edge its slot in the neighbor lists of both nodes, in list order, so that the lists
+	// can be filled in parallel
+	vector<uint32_t> degree(nodes.size(), 0), slot(2 * edge_vec.size());
+	for (size_t i = 0; i < edge_vec.size(); ++i) {
+		slot[2 * i] = degree[edge_vec[i]->n1]++;
+		slot[2 * i + 1] = degree[edge_vec[i]->n2]++;
 	}
+	run_threads(nodes.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			nodes[i].neighbors.resize(degree[i]);
+	});
+	run_threads(edge_vec.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			nodes[edge_vec[i]->n1].neighbors[slot[2 * i]] = edge_vec[i];
+			nodes[edge_vec[i]->n2].neighbors[slot[2 * i + 1]] = edge_vec[i];
+		}
+	});
 
 	message_stream << "Sorting neighborhoods..." << endl;
-	for (Node &node : nodes)
-		node.sort_neighbors();
+	run_threads(nodes.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			nodes[i].sort_neighbors();
+	});
 
 	message_stream << "Building priority queue..." << endl;
-	queue = Queue(CmpEdge(), std::move(edge_vec));
+	vector<QueueEntry> entries(edge_vec.cbegin(), edge_vec.cend());
+	queue = Queue(CmpEdge(), std::move(entries));
 	message_stream << "#Edges: " << edges.size() << endl;
 
 	return lambda;
@@ -265,19 +316,20 @@ void upgma() {
 		message_stream << "Clustering nodes..." << endl;
 		message_stream << "#Edges: " << edges.size() << ", #Nodes: " << node_count << endl;
 		while (!queue.empty()) {
-			EdgePtr e = queue.top();
+			const QueueEntry top = queue.top();
+			EdgePtr e = top.e;
 			queue.pop();
 			while (!queue.empty() && !valid(queue.top(), nodes)) {
-				EdgePtr f = queue.top();
+				EdgePtr f = queue.top().e;
 				erase(f, edges);
 				queue.pop();
 			}
-			if (!queue.empty() && !(*e <= *queue.top())) {
+			if (!queue.empty() && !(top.u <= queue.top().l)) {
 				//std::cerr << e->u << '\t' << queue.top()->l << '\t' << all_edges.print(e->n1) << '\t' << all_edges.print(e->n2) << '\t' << lambda << endl;
-				queue.push(e);
+				queue.push(top);
 				break;
 			}
-			if (valid(e, nodes) && e->u < max_dist) {
+			if (valid(top, nodes) && top.u < max_dist) {
 				merge_nodes(e->n1, e->n2, nodes, edges, queue, max_dist, lambda);
 				--node_count;
 				cout << nodes.back().parent << '\t' << all_edges.print(e->n1) << '\t' << all_edges.print(e->n2) << '\t' << e->u << endl;
@@ -49,6 +49,14 @@ struct BitVector {
 		return *this;
 	}
 
+	// complements the first n bits
+	void negate(size_t n) {
+		for (uint64_t& x : data_)
+			x = ~x;
+		if (n & 63)
+			data_.back() &= (uint64_t(1) << (n & 63)) - 1;
+	}
+
 	void reset() {
 		std::fill(data_.begin(), data_.end(), 0);
 	}
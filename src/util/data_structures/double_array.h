@@ -124,6 +124,11 @@ struct DoubleArray {
 		size_ += d.size_;
 	}
 
+	// size in bytes
+	size_t size() const {
+		return size_;
+	}
+
 	uint32_t offset(const Iterator &it) const {
 		return uint32_t(it.ptr_ - data_);
 	}
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 #include <vector>
+#include <utility>
 
 template<typename _t>
 struct FlatArray {
@@ -31,6 +32,12 @@ struct FlatArray {
 		limits_.push_back(0);
 	}
 
+	// limits holds size()+1 offsets into data, as in a CSR matrix
+	FlatArray(std::vector<_t>&& data, std::vector<size_t>&& limits):
+		data_(std::move(data)),
+		limits_(std::move(limits))
+	{}
+
 	void push_back(const _t &x) {
 		data_.push_back(x);
 		++limits_.back();
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 #include "../simd.h"
+#include "../memory/alignment.h"
 
 struct Modulo2 {};
 
@@ -59,10 +60,11 @@ public:
 	{}
 
 	HashSet(size_t size) :
-		table(new fp[size + PADDING]),
+		table((fp*)Util::Memory::aligned_malloc((size + PADDING) * sizeof(fp), (size + PADDING) * sizeof(fp) >= Util::Memory::HUGE_PAGE_SIZE ? Util::Memory::HUGE_PAGE_SIZE : 32)),
 		size_(size),
 		destroy_(true)
 	{
+		Util::Memory::advise_huge_pages(table, (size_ + PADDING) * sizeof(fp));
 		memset(table, 0, (size_ + PADDING) * sizeof(fp));
 	}
 
@@ -74,14 +76,31 @@ public:
 
 	~HashSet() {
 		if (destroy_)
-			delete[] table;
+			Util::Memory::aligned_free(table);
 	}
 
 	bool contains(uint64_t key) const
+	{
+		return contains(key, bucket(key));
+	}
+
+	// First entry of the probe sequence of a key, to be prefetched ahead of contains(key, bucket(key)).
+	const fp* bucket(uint64_t key) const
+	{
+		return table + modulo<_mod>(_hash()(key) >> (sizeof(fp) * 8), size_);
+	}
+
+	static void prefetch(const fp* p)
+	{
+#ifdef __SSE2__
+		_mm_prefetch((const char*)p, _MM_HINT_T0);
+#endif
+	}
+
+	bool contains(uint64_t key, const fp* p) const
 	{
 #ifdef USE_AVX
 		const uint64_t hash = _hash()(key);
-		fp* p = table.get() + modulo<_mod>(hash >> (sizeof(fp) * 8), size_);
 		__m256i r = _mm256_loadu_si256((const __m256i*)p);
 		__m256i z = _mm256_setzero_si256();
 		const int zm = _mm256_movemask_epi8(_mm256_cmpeq_epi8(r, z));
@@ -94,7 +113,6 @@ public:
 		return fm != 0;
 #elif defined(__SSE2__)
 		const uint64_t hash = _hash()(key);
-		fp* p = table + modulo<_mod>(hash >> (sizeof(fp) * 8), size_);
 		__m128i r = _mm_loadu_si128((const __m128i*)p);
 		__m128i z = _mm_setzero_si128();
 		const int zm = _mm_movemask_epi8(_mm_cmpeq_epi8(r, z));
@@ -106,8 +124,8 @@ public:
 		const int fm = _mm_movemask_epi8(_mm_cmpeq_epi8(r, fr));
 		return fm != 0;
 #else
-		fp* p;
-		return get_entry(key, p);
+		fp* e;
+		return get_entry(key, e);
 #endif
 	}
 
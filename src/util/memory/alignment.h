@@ -22,6 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include <cstddef>
 #include <exception>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 namespace Util { namespace Memory {
 
@@ -47,6 +51,19 @@ static inline void aligned_free(void* p) {
 #endif
 }
 
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Advises the kernel to back the huge page aligned part of a range with transparent huge pages, which saves TLB misses
+// on random accesses to large tables. This is a hint only and does nothing on other systems.
+static inline void advise_huge_pages(const void* p, size_t n) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    const uintptr_t begin = ((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1),
+        end = ((uintptr_t)p + n) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (end > begin)
+        madvise((void*)begin, end - begin, MADV_HUGEPAGE);
+#endif
+}
+
 template <typename T, std::size_t N = 16>
 class AlignmentAllocator {
 public:
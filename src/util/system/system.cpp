@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdexcept>
 #include <string.h>
 #include <iostream>
+#include <fstream>
 #include "system.h"
 #include "../string/string.h"
 #include "../log_stream.h"
@@ -23,6 +25,11 @@
       #include <sys/sysinfo.h>
     #endif
   #endif
+  #ifdef __linux__
+    #include <sched.h>
+    #include <pthread.h>
+    #include <sys/syscall.h>
+  #endif
 #endif
 
 using std::string;
@@ -198,4 +205,104 @@ size_t l3_cache_size() {
 	const auto s = sysconf(_SC_LEVEL3_CACHE_SIZE);
 	return s == -1 ? 0 : s;
 #endif
+}
+
+size_t l2_cache_size() {
+#if defined(_MSC_VER) || defined(__APPLE__) || defined(__FreeBSD__)
+	return 0;
+#else
+	const auto s = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	return s == -1 ? 0 : s;
+#endif
+}
+
+string hostname() {
+#ifdef _MSC_VER
+	char buf[MAX_COMPUTERNAME_LENGTH + 1];
+	DWORD n = sizeof(buf);
+	return GetComputerNameA(buf, &n) ? string(buf) : string();
+#else
+	char buf[256];
+	if (gethostname(buf, sizeof(buf)) != 0)
+		return string();
+	buf[sizeof(buf) - 1] = 0;
+	return string(buf);
+#endif
+}
+
+#ifdef __linux__
+// Parses the sysfs list format, e.g. "0-3,8,10-11".
+static std::vector<int> parse_cpu_list(const string& s) {
+	std::vector<int> r;
+	size_t i = 0;
+	while (i < s.length()) {
+		size_t j = s.find(',', i);
+		if (j == string::npos)
+			j = s.length();
+		const string item = s.substr(i, j - i);
+		const size_t d = item.find('-');
+		if (!item.empty()) {
+			const int b = std::stoi(item.substr(0, d)), e = d == string::npos ? b : std::stoi(item.substr(d + 1));
+			for (int k = b; k <= e; ++k)
+				r.push_back(k);
+		}
+		i = j + 1;
+	}
+	return r;
+}
+
+static string read_line(const string& file) {
+	std::ifstream f(file);
+	string s;
+	std::getline(f, s);
+	return s;
+}
+#endif
+
+const std::vector<NumaNode>& numa_nodes() {
+	static const std::vector<NumaNode> nodes = []() {
+		std::vector<NumaNode> r;
+#ifdef __linux__
+		try {
+			for (int id : parse_cpu_list(read_line("/sys/devices/system/node/online"))) {
+				std::vector<int> cpus = parse_cpu_list(read_line("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+				if (!cpus.empty())
+					r.push_back({ id, std::move(cpus) });
+			}
+		}
+		catch (std::exception&) {
+			r.clear();
+		}
+#endif
+		return r;
+	}();
+	return nodes;
+}
+
+bool pin_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int i : cpus)
+		if (i < CPU_SETSIZE)
+			CPU_SET(i, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+void numa_bind(const void* ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+	// constants from linux/mempolicy.h
+	const int MPOL_PREFERRED_ = 1;
+	const unsigned MPOL_MF_MOVE_ = 1 << 1;
+	const uintptr_t page = sysconf(_SC_PAGESIZE),
+		begin = ((uintptr_t)ptr + page - 1) / page * page,
+		end = ((uintptr_t)ptr + size) / page * page;
+	if (end <= begin || node < 0 || node >= 64)
+		return;
+	const unsigned long mask = 1ul << node;
+	syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED_, &mask, sizeof(mask) * 8 + 1, MPOL_MF_MOVE_);
+#endif
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string>
 #include <tuple>
+#include <vector>
 
 enum class Color { RED, GREEN, YELLOW };
 
@@ -19,6 +20,20 @@ double total_ram();
 std::tuple<char*, size_t, int> mmap_file(const char* filename);
 void unmap_file(char* ptr, size_t size, int fd);
 size_t l3_cache_size();
+size_t l2_cache_size();
+std::string hostname();
+
+struct NumaNode {
+	int id;
+	std::vector<int> cpus;
+};
+
+// NUMA nodes with at least one CPU. Returns an empty list if the topology is not available.
+const std::vector<NumaNode>& numa_nodes();
+// Restricts the calling thread to the given CPUs. Returns false if not supported.
+bool pin_thread(const std::vector<int>& cpus);
+// Moves the pages fully contained in the memory range to the given node. Best effort, errors are ignored.
+void numa_bind(const void* ptr, size_t size, int node);
 
 #ifdef _MSC_VER
 #define POPEN _popen